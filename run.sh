@@ -17,7 +17,7 @@ SOURCES=( # Source files
 
 #  By enabling -flto flag, perform optimizations across object files,
 #  including removing unused functions.
-FLAGS="-flto -lraylib -lm" # raylib library
+FLAGS="-flto -lraylib -lm -lpthread" # raylib library, map generation worker threads
 GCC_FLAGS="-pedantic-errors -Wall -Wextra -Wsign-conversion -std=gnu99"
 INCLUDE_DIR="/usr/local/include" # raylib headers
 
@@ -45,6 +45,15 @@ do
     case "$1" in
         debug) GCC_FLAGS="$GCC_FLAGS -g3 -D DEBUG"
             ;;
+        bench) # Headless map generation benchmark, see src/tools/map_bench.c
+            OUTPUT="${OUTPUT/DungeonDelveC/MapBench}"
+            SOURCES=("src/tools/map_bench.c" "src/entity/*.c" "src/render/*.c" "src/map/*.c" "src/utils/*.c")
+            FLAGS="$FLAGS -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free" # Allocation counters
+            ;;
+        seeds) # Headless seed explorer, see src/tools/seed_explorer.c
+            OUTPUT="${OUTPUT/DungeonDelveC/SeedExplorer}"
+            SOURCES=("src/tools/seed_explorer.c" "src/entity/*.c" "src/render/*.c" "src/map/*.c" "src/utils/*.c")
+            ;;
     esac
     shift
 done
@@ -15,6 +15,8 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "enemy.h"
+#include "../map/maps.h"
+#include "../map/distance_field.h"
 
 static float last_time_attacked = 0;
 static float last_collision_time = 0;
@@ -47,21 +49,64 @@ Enemy* InitEnemy(int spawn_x, int spawn_y){
 
 }
 
+void FreeEnemy(Enemy *enemy){
+
+    UnloadSound(enemy->entity.take_damage_sound);
+    UnloadSound(enemy->entity.death_sound);
+    free(enemy);
+
+}
+
+// Puts an enemy back to its initial state on a new spawn, keeping the loaded sounds
+void RespawnEnemy(Enemy *enemy, int spawn_x, int spawn_y){
+
+    Vector2 spawn = (Vector2){spawn_x, spawn_y};
+
+    enemy->entity.spawn_point = spawn;
+    enemy->entity.position = spawn;
+    enemy->entity.last_position = spawn;
+    enemy->entity.health = ENEMY_BASE_HEALTH;
+    enemy->entity.stamina = ENEMY_BASE_STAMINA;
+    enemy->entity.mana = ENEMY_BASE_MANA;
+    enemy->entity.isAlive = true;
+    enemy->entity.isAttacking = false;
+    enemy->entity.isMoving = false;
+    enemy->Y_frame = 0;
+
+}
+
+// Puts an enemy back as it was when the player left its level (see level_graph.h)
+void RestoreEnemy(Enemy *enemy, Vector2 spawn_point, Vector2 position, float health, bool isAlive){
+
+    if (isAlive) {
+        RespawnEnemy(enemy, (int)spawn_point.x, (int)spawn_point.y);
+    } else {
+        enemy->entity.spawn_point = spawn_point;
+        enemy->entity.isAlive = false;
+        enemy->entity.isMoving = false;
+        enemy->Y_frame = 1;
+    }
+
+    enemy->entity.position = position;
+    enemy->entity.last_position = position;
+    enemy->entity.health = health;
+
+}
+
 /// ====================================================================================================
 
 void UpdateEnemiesMap(MapNode *TileMap, float deltaTime, unsigned int currentFrame, Player* player) {
     for (int i = 0; i < TileMap->num_enemies ; i++) {
-        UpdateEnemy(TileMap->enemies[i], player, deltaTime, currentFrame);
+        UpdateEnemy(TileMap->enemies[i], player, TileMap, deltaTime, currentFrame);
 
     }
 }
 
-void UpdateEnemy(Enemy *enemy, Player* player, float deltaTime, unsigned int currentFrame) {
+void UpdateEnemy(Enemy *enemy, Player* player, MapNode *map, float deltaTime, unsigned int currentFrame) {
     
     if (!enemy->entity.isAlive) return;
     
     if (enemy->entity.health <= 0){ 
-        UnloadTexture(enemy->entity.texture);   // Unload the texture (make sure that you dont draw it anymore)
         PlaySound(enemy->entity.death_sound);   // Play the death sound
         enemy->entity.isAlive = false;
         enemy->Y_frame = 1;                     // Change the 'y' axis to the death animation
@@ -70,7 +115,7 @@ void UpdateEnemy(Enemy *enemy, Player* player, float deltaTime, unsigned int cur
 
     enemy->entity.last_position = enemy->entity.position;
 
-    isMoving(enemy, player, deltaTime);
+    isMoving(enemy, player, map, deltaTime);
 
     if (!enemy->entity.isMoving) return;
 
@@ -123,7 +168,37 @@ void handleCollision(Enemy *enemy, Player* player, float deltaTime, int directio
     }
 }
 
-void isMoving(Enemy *enemy, Player* player, float deltaTime) {
+static Rectangle GetEnemyArea(Vector2 position) {
+    return (Rectangle){position.x, position.y, __TILE_SIZE, __TILE_SIZE};
+}
+
+// Moves the enemy unless that takes it into a wall, enemies spawned inside a wall can still leave it.
+// A move into a slanted wall slides along it: the distance field gradient points away from the
+// wall, the part of the move across it is dropped
+static void MoveEnemy(Enemy *enemy, MapNode *map, float deltaX, float deltaY) {
+    Vector2 previous = enemy->entity.position;
+    bool wasBlocked = IsAreaBlocking(map, GetEnemyArea(previous));
+
+    UpdateEntityPosition(&enemy->entity, deltaX, deltaY);
+
+    if (wasBlocked || !IsAreaBlocking(map, GetEnemyArea(enemy->entity.position))) return;
+
+    enemy->entity.position = previous;
+
+    int tile_x = (int)((previous.x + __TILE_SIZE / 2) / __TILE_SIZE);
+    int tile_y = (int)((previous.y + __TILE_SIZE / 2) / __TILE_SIZE);
+    Vector2 away = GetWallGradient(map, tile_x, tile_y);
+    float length = Vector2Length(away);
+    if (length == 0) return;
+
+    Vector2 along = {-away.y / length, away.x / length};
+    float slide = deltaX * along.x + deltaY * along.y;
+
+    UpdateEntityPosition(&enemy->entity, along.x * slide, along.y * slide);
+    if (IsAreaBlocking(map, GetEnemyArea(enemy->entity.position))) enemy->entity.position = previous;
+}
+
+void isMoving(Enemy *enemy, Player* player, MapNode *map, float deltaTime) {
     enemy->entity.isMoving = true;
 
     bool LEFT = enemy->entity.position.x < player->entity.position.x;
@@ -131,29 +206,29 @@ void isMoving(Enemy *enemy, Player* player, float deltaTime) {
     bool UP = enemy->entity.position.y < player->entity.position.y;
     bool DOWN = enemy->entity.position.y > player->entity.position.y;
 
-    enemy->entity.texture.width < 0 && LEFT ? enemy->entity.texture.width *= -1 : 0;
-    enemy->entity.texture.width > 0 && RIGHT ? enemy->entity.texture.width *= -1 : 0;
+    if (LEFT) enemy->entity.flipped = false;
+    if (RIGHT) enemy->entity.flipped = true;
 
     if (LEFT || RIGHT || UP || DOWN) enemy->entity.isMoving = true;
     else enemy->entity.isMoving = false;
 
     if (LEFT){
-        UpdateEntityPosition(&enemy->entity, enemy->entity.speed * deltaTime, 0);
+        MoveEnemy(enemy, map, enemy->entity.speed * deltaTime, 0);
         handleCollision(enemy, player, deltaTime, -1, 0);
     }
 
     if (RIGHT){
-        UpdateEntityPosition(&enemy->entity, -enemy->entity.speed * deltaTime, 0);
+        MoveEnemy(enemy, map, -enemy->entity.speed * deltaTime, 0);
         handleCollision(enemy, player, deltaTime, 1, 0);
     }
 
     if (UP){
-        UpdateEntityPosition(&enemy->entity, 0, enemy->entity.speed * deltaTime);
+        MoveEnemy(enemy, map, 0, enemy->entity.speed * deltaTime);
         handleCollision(enemy, player, deltaTime, 0, -1);
     }
 
     if (DOWN){
-        UpdateEntityPosition(&enemy->entity, 0, -enemy->entity.speed * deltaTime);
+        MoveEnemy(enemy, map, 0, -enemy->entity.speed * deltaTime);
         handleCollision(enemy, player, deltaTime, 0, 1);
     }
 }
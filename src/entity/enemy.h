@@ -31,12 +31,16 @@
 #define ENEMY_SPRITESHEET_HEIGHT 1
 
 Enemy* InitEnemy(int spawn_x, int spawn_y);
+void RespawnEnemy(Enemy *enemy, int spawn_x, int spawn_y);
+void FreeEnemy(Enemy *enemy);
+void RestoreEnemy(Enemy *enemy, Vector2 spawn_point, Vector2 position, float health, bool isAlive);
 void UpdateEnemiesMap(MapNode *TileMap, float deltaTime, unsigned int currentFrame, Player* player) ;
-void UpdateEnemy(Enemy *enemy, Player* player, float deltaTime, unsigned int currentFrame);
+void UpdateEnemy(Enemy *enemy, Player* player, MapNode *map, float deltaTime, unsigned int currentFrame);
 void throwEnemyBack(Enemy *enemy, float deltaTime, int directionX, int directionY);
 bool isCollision(Enemy *enemy, Player* player);
+void updatePlayerHealth(Player* player); // One hit, at most once per second (enemies and hazards)
 void handleCollision(Enemy *enemy, Player* player, float deltaTime, int directionX, int directionY);
-void isMoving(Enemy *enemy, Player* player, float deltaTime);
+void isMoving(Enemy *enemy, Player* player, MapNode *map, float deltaTime);
 void DrawEnemyMap(MapNode *TileMap) ;
 void DrawEnemy(Enemy *enemy);
 void UpdateFrameRec(Enemy *enemy, int currentFrame) ;
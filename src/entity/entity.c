@@ -15,15 +15,16 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "entity.h"
+#include "../render/atlas.h"
 
 Entity InitEntity(Vector2 spawn, float health, float stamina, float mana, int damage, float speed,
 char* texture_path, int texture_width, int texture_height, char* damage_sound_path, char* death_sound_path){
 
     Entity entity;
-    entity.texture = LoadTexture(texture_path);
+    entity.sprite = GetSprite(texture_path);
     entity.frameRec = (Rectangle){0, 0, 0, 0};
-    entity.frameRec.width = entity.texture.width/texture_width;
-    entity.frameRec.height = entity.texture.height/texture_height;
+    entity.frameRec.width = (int)entity.sprite.source.width/texture_width;
+    entity.frameRec.height = (int)entity.sprite.source.height/texture_height;
     entity.take_damage_sound = LoadSound(damage_sound_path);
     entity.death_sound = LoadSound(death_sound_path);
 
@@ -38,6 +39,8 @@ char* texture_path, int texture_width, int texture_height, char* damage_sound_pa
     entity.isAlive = true;
     entity.isAttacking = false;
     entity.isMoving = false;
+    entity.isPlayer = false;
+    entity.flipped = false;
 
     return entity;
 
@@ -126,8 +129,8 @@ void UpdateEntityPosition(Entity *entity, float deltaX, float deltaY){
 void UpdateEntityFrameRec(Entity *entity, unsigned int currentFrame_x, unsigned int currentFrame_y,
                             int spriteSheetWidth, int spriteSheetHeight){  
                                 
-    entity->frameRec.x = (float)currentFrame_x * (float)entity->texture.width / spriteSheetWidth;
-    entity->frameRec.y = (float)currentFrame_y * (float)entity->texture.height / spriteSheetHeight;
+    entity->frameRec.x = (float)currentFrame_x * entity->sprite.source.width / spriteSheetWidth;
+    entity->frameRec.y = (float)currentFrame_y * entity->sprite.source.height / spriteSheetHeight;
 }
 
 void DrawEntity(Entity entity, int entity_size, int entity_origin_x, int entity_origin_y, int base_health){
@@ -145,7 +148,8 @@ void DrawEntity(Entity entity, int entity_size, int entity_origin_x, int entity_
     }
     
     
-    DrawTexturePro(entity.texture, entity.frameRec, entityRec, entityOrigin, 0, WHITE);
+    // The bars are drawn from the white block of the atlas, same batch as the sprite
+    DrawTexturePro(entity.sprite.texture, GetSpriteFrame(entity.sprite, entity.frameRec, entity.flipped), entityRec, entityOrigin, 0, WHITE);
 
     #ifdef DEBUG
     DrawRectangleLines(entityRec.x, entityRec.y, entity_size/2, entity_size/2, RED);
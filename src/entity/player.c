@@ -17,6 +17,10 @@
 #include "player.h"
 #include "paths.h"
 #include "../render/render.h"
+#include "../map/maps.h"
+#include "../map/hazards.h"
+#include "../map/map_edit.h"
+#include "enemy.h"
 
 static int last_attack = 0;
 static int frame_counter = 0;
@@ -64,43 +68,45 @@ Player* InitPlayer(MapNode *Map){
 #define BOTTOM_RIGHT_VERTEX 3
 uint8_t LAST_COLLISION_TYPE = 0;
 void FallBackPlayerToLastPlayerPostionInCaseOfWallCollisionAndUpdateLAST_COLLISION_TYPE(Player *player, MapNode *map) {
-    static uint8_t checking = TOP_LEFT_VERTEX;
-    static bool hasCollided = false;
-    for(uint8_t i=0; i<4; i++) {
-        static uint32_t vertexX, vertexY;
-        switch (checking) {
-            case TOP_LEFT_VERTEX:
-                vertexX = player->entity.position.x/16;
-                vertexY = player->entity.position.y/16;
-                checking = TOP_RIGHT_VERTEX;
-                break;
-            case TOP_RIGHT_VERTEX:
-                vertexX = (player->entity.position.x+8)/16;
-                vertexY = player->entity.position.y/16;
-                checking = BOTTOM_LEFT_VERTEX;
-                break;
-            case BOTTOM_LEFT_VERTEX:
-                vertexX = player->entity.position.x/16;
-                vertexY = (player->entity.position.y+10)/16;
-                checking = BOTTOM_RIGHT_VERTEX;
-                break;
-            case BOTTOM_RIGHT_VERTEX:
-                vertexX = (player->entity.position.x+8)/16;
-                vertexY = (player->entity.position.y+10)/16;
-                break;
-        }
-        if(map->tile_info[vertexY][vertexX].blocking == true && CheckCollisionRecs((Rectangle){player->entity.position.x, player->entity.position.y, 8, 10}, map->tile_info[vertexY][vertexX].rect)) {
-            player->entity.position = player->entity.last_position;
-            if (map->tile_info[vertexY][vertexX].isStair) LAST_COLLISION_TYPE = STAIR;
-            if (map->tile_info[vertexY][vertexX].isHole)  LAST_COLLISION_TYPE = HOLE;
-            hasCollided = true;
+    Rectangle hitbox = {player->entity.position.x, player->entity.position.y, 8, 10};
+
+    if (!IsAreaBlocking(map, hitbox)) {
+        player->entity.last_position = player->entity.position;
+        return;
+    }
+
+    // Only on a collision: find out if one of the vertices hit a stair, a hole or a ladder
+    int left = (int)(hitbox.x / __TILE_SIZE), right = (int)((hitbox.x + hitbox.width) / __TILE_SIZE);
+    int top = (int)(hitbox.y / __TILE_SIZE), bottom = (int)((hitbox.y + hitbox.height) / __TILE_SIZE);
+    int vertices[4][2] = {{left, top}, {right, top}, {left, bottom}, {right, bottom}};
+
+    for (uint8_t i = 0; i < 4; i++) {
+        int vertexX = vertices[i][0], vertexY = vertices[i][1];
+        if (!IsInsideMap(map, vertexX, vertexY)) continue;
+
+        uint8_t flags = GetTileFlags(map, vertexX, vertexY);
+        if ((flags & TILE_FLAG_BLOCKING) && CheckCollisionRecs(hitbox, GetTileRect(vertexX, vertexY))) {
+            if (flags & TILE_FLAG_STAIR) LAST_COLLISION_TYPE = STAIR;
+            if (flags & TILE_FLAG_HOLE)  LAST_COLLISION_TYPE = HOLE;
+            if (flags & TILE_FLAG_LADDER) LAST_COLLISION_TYPE = LADDER;
         }
     }
-    if(!hasCollided) player->entity.last_position = player->entity.position;
 
-    //if arrived here, these values should be reseted
-    hasCollided = false;
-    checking = TOP_LEFT_VERTEX;
+    player->entity.position = player->entity.last_position;
+}
+
+// Breaks the cracked wall the player faces, the sprite is flipped when facing left
+static void HitFacingTile(Player *player, MapNode *map) {
+    float reach = __TILE_SIZE * 0.75f;
+    float x = player->entity.position.x + 4, y = player->entity.position.y + 5; // Center of the hitbox
+
+    switch (player->last_animation) {
+        case SIDE_ATTACK_ANIMATION: x += player->entity.flipped ? -reach : reach; break;
+        case BACK_ATTACK_ANIMATION: y -= reach; break;
+        case FRONT_ATTACK_ANIMATION: y += reach; break;
+    }
+
+    BreakTile(map, (int)floorf(x / __TILE_SIZE), (int)floorf(y / __TILE_SIZE));
 }
 
 uint8_t *UpdatePlayer(Player *player, float deltaTime, unsigned int currentFrame, MapNode *map) {
@@ -110,9 +116,14 @@ uint8_t *UpdatePlayer(Player *player, float deltaTime, unsigned int currentFrame
         player->entity.isMoving = false;     // if player is moving, already set to false
     } else {
         isAttacking(player);
-        if (!player->entity.isAttacking) updatePlayerPositionIfMoving(player, deltaTime, map);
+        if (player->entity.isAttacking) HitFacingTile(player, map); // Once, when the attack starts
+        else updatePlayerPositionIfMoving(player, deltaTime, map);
     }
 
+    // Raised spikes under the feet, enemies fly over them
+    Rectangle hitbox = {player->entity.position.x, player->entity.position.y, 8, 10};
+    if (IsAreaOnArmedHazard(map, hitbox)) updatePlayerHealth(player);
+
     if (!player->entity.isMoving && !player->entity.isAttacking) {
         PlayIdleAnimation(player, currentFrame);
     } else {         
@@ -150,8 +161,8 @@ void updatePlayerPositionIfMoving(Player *player, float deltaTime, MapNode *map)
 
     if ((LEFT || RIGHT) && (UP || DOWN)) player_speed /= 1.5;
 
-    player->entity.texture.width > 0 && LEFT ? player->entity.texture.width *= -1 : 0;
-    player->entity.texture.width < 0 && RIGHT ? player->entity.texture.width *= -1 : 0;
+    if (LEFT) player->entity.flipped = true;
+    if (RIGHT) player->entity.flipped = false;
     
     if (LEFT) updatePlayerPosition(player, -player_speed, 0, SIDE_WALK_ANIMATION);
     FallBackPlayerToLastPlayerPostionInCaseOfWallCollisionAndUpdateLAST_COLLISION_TYPE(player, map);
@@ -161,7 +172,7 @@ void updatePlayerPositionIfMoving(Player *player, float deltaTime, MapNode *map)
     FallBackPlayerToLastPlayerPostionInCaseOfWallCollisionAndUpdateLAST_COLLISION_TYPE(player, map);
     if (DOWN) updatePlayerPosition(player, 0, player_speed, FRONT_WALK_ANIMATION);
     FallBackPlayerToLastPlayerPostionInCaseOfWallCollisionAndUpdateLAST_COLLISION_TYPE(player, map);
-    PlaySound(player->walk_sounds[rand() % 3]);
+    PlaySound(player->walk_sounds[RandomRange(RNG_STREAM_AUDIO, COUNT_WALK_SOUNDS)]);
 }
 
 void isAttacking(Player *player) {
@@ -16,6 +16,9 @@
 
 #include "events.h"
 
+// Sizes offered in the world settings, maps bigger than MAP_STREAMING_THRESHOLD are streamed
+static const int mapSizes[] = {50, 100, 250, 500, 1000, 5000, 20000};
+
 static const char* pauseOptions[] = {
     "Resume", 
     "Back to Menu",
@@ -95,18 +98,28 @@ void handleDifficultySelection(MenuData* menuData, MenuSounds* menuSounds) {
 void handleWorldSettingsSelection(MenuData* menuData, MenuSounds* menuSounds) {
     PlaySound(menuSounds->selectOptionSound);
     switch (menuData->selectedOption) {
-        case 0:  // Map Size
-            menuData->MapSize = 50 + ((menuData->MapSize - 50 + 50) % (menuData->MapMaxSize - 50 + 50));
-            if (menuData->MapSize < 50) menuData->MapSize = 50;
+        case 0: {  // Map Size
+            int nextSize = mapSizes[0];
+            for (size_t i = 0; i < ARRAY_LEN(mapSizes); i++) {
+                if (mapSizes[i] > menuData->MapSize && mapSizes[i] <= menuData->MapMaxSize) {
+                    nextSize = mapSizes[i];
+                    break;
+                }
+            }
+            menuData->MapSize = nextSize;
             break;
+        }
         case 1:  // Map Seed
-            menuData->MapSeed = rand() % menuData->MaxSeed;
+            menuData->MapSeed = (int)RandomRange(RNG_STREAM_MENU, (uint32_t)menuData->MaxSeed);
+            break;
+        case 2:  // Map Type
+            menuData->generator = (uint8_t)((menuData->generator + 1) % MAP_GENERATOR_COUNT);
             break;
-        case 2:  // Back
+        case 3:  // Back
             menuData->currentState = MENU_DIFFICULTY;
             menuData->selectedOption = 0;
             break;
-        case 3:  // Start Game
+        case 4:  // Start Game
             initGame();
             break;
     }
@@ -134,19 +147,59 @@ void handleMultiplayerSelection(MenuData* menuData, MenuSounds* menuSounds) {
     }
 }
 
-void StartPlayerOnNewMap(Player* player, int collisionType, MenuData* MapInfo, MapNode* TileMap){
-    player->entity.position = player->entity.spawn_point; // Avoid collision with the new map
-
-    GenerateMap(TileMap);
-    LoadingWindow();
+static uint16_t NextMapLevel(uint16_t map_level, int collisionType){
     switch (collisionType) {
         case STAIR:
-            MapInfo->map_level++;
-            break;
+            return (uint16_t)(map_level + 1);
         case HOLE:
-            MapInfo->map_level = MapInfo->map_level == 0 ? 2 : MapInfo->map_level << 1;
-            break;
+            return map_level == 0 ? 2 : (uint16_t)(map_level << 1);
     }
+    return map_level;
+}
+
+// Each level has its own seed, derived from the world seed
+static uint32_t MapLevelSeed(const MenuData* MapInfo, uint16_t map_level, int collisionType){
+    return RngHash2D((uint32_t)MapInfo->MapSeed, RNG_STREAM_LEVELS, map_level, collisionType);
+}
+
+// Starts generating the levels below the current one in the background, the ones already
+// visited are in the level graph
+void PrefetchNextLevels(const MenuData* MapInfo, const MapNode* TileMap){
+    if (GetLevelLink(TileMap->node_id, LEVEL_LINK_STAIR) == LEVEL_NONE)
+        PrefetchLevel(0, TileMap, MapLevelSeed(MapInfo, NextMapLevel(MapInfo->map_level, STAIR), STAIR));
+    if (GetLevelLink(TileMap->node_id, LEVEL_LINK_HOLE) == LEVEL_NONE)
+        PrefetchLevel(1, TileMap, MapLevelSeed(MapInfo, NextMapLevel(MapInfo->map_level, HOLE), HOLE));
+}
+
+void StartPlayerOnNewMap(Player* player, int collisionType, MenuData* MapInfo, MapNode* TileMap){
+    LevelLink link = collisionType == STAIR ? LEVEL_LINK_STAIR : collisionType == HOLE ? LEVEL_LINK_HOLE : LEVEL_LINK_UP;
+    int next = GetLevelLink(TileMap->node_id, link);
+
+    if (link == LEVEL_LINK_UP && next == LEVEL_NONE) return; // The ladder of the first level leads nowhere
+
+    SaveLevel(TileMap, player->entity.position);
+
+    if (next == LEVEL_NONE) {
+        uint16_t map_level = NextMapLevel(MapInfo->map_level, collisionType);
+        next = AddLevel(TileMap->node_id, link, MapLevelSeed(MapInfo, map_level, collisionType), map_level);
+    }
+
+    const LevelNode* level = GetLevelNode(next);
+    MapInfo->map_level = level->map_level;
+
+    // Visited levels come back as they were left, the others are swapped in if they were
+    // prefetched or generated here
+    if (!RestoreLevel(TileMap, next)) {
+        TileMap->node_id = next;
+        TileMap->seed = level->seed;
+        GenerateMap(TileMap);
+    }
+
+    // Back up where the player left the level above, down next to the ladder
+    player->entity.position = (link == LEVEL_LINK_UP) ? level->exit_position : player->entity.spawn_point;
+    player->entity.last_position = player->entity.position;
+
+    PrefetchNextLevels(MapInfo, TileMap);
 }
 
 
@@ -172,11 +225,13 @@ void handleMainMenuSelection(MenuData* menuData, MenuSounds* menuSounds) {
 }
 
 void UpdateOptions(MenuData* menuData, MenuSounds* menuSounds) {
+    int options = menuData->currentState == MENU_WORLD_SETTINGS ? WORLD_OPTIONS : MAX_OPTIONS;
+
     if (IsKeyPressed(KEY_DOWN)) {
-        menuData->selectedOption = (menuData->selectedOption + 1) % MAX_OPTIONS;
+        menuData->selectedOption = (menuData->selectedOption + 1) % options;
         PlaySound(menuSounds->changeOptionSound);
     } else if (IsKeyPressed(KEY_UP)) {
-        menuData->selectedOption = (menuData->selectedOption - 1 + MAX_OPTIONS) % MAX_OPTIONS;
+        menuData->selectedOption = (menuData->selectedOption - 1 + options) % options;
         PlaySound(menuSounds->changeOptionSound);
     }
 
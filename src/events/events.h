@@ -19,10 +19,13 @@
 
 #include "../render/render.h"
 #include "../map/maps.h"
+#include "../map/prefetch.h"
+#include "../map/level_graph.h"
 #include "../menu.h"
 
 int PauseEvent(void);
 void LoadingWindow(void);
+void PrefetchNextLevels(const MenuData* MapInfo, const MapNode* TileMap);
 void StartPlayerOnNewMap(Player* player, int collisionType, MenuData* MapInfo, MapNode* TileMap);
 void UpdateOptions(MenuData* menuData, MenuSounds* menuSounds);
 void handleMainMenuSelection(MenuData* menuData, MenuSounds* menuSounds);
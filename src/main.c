@@ -21,7 +21,9 @@
 #include "render/render.h"
 #include "utils/utils.h"
 #include "events/events.h"
+#include "map/hazards.h"
 #include "network.h"
+#include "render/atlas.h"
 
 
 
@@ -98,13 +100,11 @@ int main(void) {
             }
 
             int pauseAction = handlePause();
-            if (pauseAction == 1 || pauseAction == 2) {
+            if (pauseAction == 2) {
                 freeResources(mapInfo, tileMap, localPlayer, allPlayers, myID, numClients, backgroundMusic, serverSocket, clientSockets);
-                if (pauseAction == 2) {
-                    return 0;
-                }
-                break;
+                return 0;
             }
+            if (pauseAction == 1) break; // Freed below, like when the window is closed
         }
 
         freeResources(mapInfo, tileMap, localPlayer, allPlayers, myID, numClients, backgroundMusic, serverSocket, clientSockets);
@@ -116,12 +116,15 @@ void initializeBasics() {
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_TITLE);
     SetTargetFPS(TARGET_FPS);
     InitAudioDevice();
+    InitAtlas();
 }
 
 void setupGame(MenuData* mapInfo, GameVariables* gameVar, MapNode** tileMap, Player** localPlayer, Camera2D* camera, Music* backgroundMusic) {
     *tileMap = mapInfo->TileMapGraph;
     *localPlayer = InitPlayer(*tileMap);
     *camera = InitPlayerCamera(*localPlayer);
+    InitLevelGraph(*tileMap, mapInfo->map_level);
+    PrefetchNextLevels(mapInfo, *tileMap);
     InitRandomSeed(NULL);
     *backgroundMusic = LoadMusicStream(BACKGROUND_MUSIC);
     PlayMusicStream(*backgroundMusic);
@@ -132,8 +135,10 @@ void updateGame(GameVariables* gameVar, Player* localPlayer, MapNode* tileMap, C
     gameVar->update(gameVar);
     uint8_t* collisionType = localPlayer->update(localPlayer, gameVar->delta_time, gameVar->current_frame, tileMap);
     localPlayer->updateCamera(camera, localPlayer, gameVar->delta_time);
+    StreamMap(tileMap, *camera);
+    UpdateHazards(tileMap, gameVar->delta_time);
     tileMap->updateEnemies(tileMap, gameVar->delta_time, gameVar->current_frame, localPlayer);
-    if (*collisionType == STAIR || *collisionType == HOLE) {
+    if (*collisionType == STAIR || *collisionType == HOLE || *collisionType == LADDER) {
         StartPlayerOnNewMap(localPlayer, *collisionType, mapInfo, tileMap);
         *collisionType = NO_COLLISION;
     }
@@ -180,11 +185,14 @@ int handlePause() {
 }
 
 void freeResources(MenuData* mapInfo, MapNode* tileMap, Player* localPlayer, Player* allPlayers[], int myID, int numClients, Music backgroundMusic, int serverSocket, int clientSockets[]) {
+    // The map unloads its sounds and the atlas its texture, so they go before the window and the audio device
+    StopPrefetch();
+    FreeLevelGraph();
+    FreeMap(tileMap);
     UnloadMusicStream(backgroundMusic);
+    FreeAtlas();
     CloseAudioDevice();
     CloseWindow();
-    free(tileMap);
-    free(mapInfo);
     free(localPlayer);
     if (mapInfo->isServer) {
         for (int i = 0; i < numClients; i++) {
@@ -200,6 +208,7 @@ void freeResources(MenuData* mapInfo, MapNode* tileMap, Player* localPlayer, Pla
             }
         }
     }
+    free(mapInfo);
 }
 
 void UpdateGameVariables(GameVariables* game_variables) {
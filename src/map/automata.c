@@ -0,0 +1,124 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "automata.h"
+
+static CaveRules cave_rules = {
+    .iterations = CAVE_DEFAULT_ITERATIONS,
+    .birth = CAVE_DEFAULT_BIRTH,
+    .survival = CAVE_DEFAULT_SURVIVAL,
+};
+
+void SetCaveRules(CaveRules rules){
+    if (rules.iterations < 0) rules.iterations = 0;
+    if (rules.iterations > CAVE_MAX_CHUNK_ITERATIONS) rules.iterations = CAVE_MAX_CHUNK_ITERATIONS;
+    cave_rules = rules;
+}
+
+CaveRules GetCaveRules(void){
+    return cave_rules;
+}
+
+uint32_t PackCaveRules(CaveRules rules){
+    return (uint32_t)rules.iterations << 18 | (uint32_t)(rules.birth & 0x1FF) << 9 | (rules.survival & 0x1FF);
+}
+
+// Word of the row, with the bits outside the plane set (they count as walls)
+static inline uint64_t LoadWord(const uint64_t* row, size_t word, size_t stride, int width) {
+    if (row == NULL || word >= stride) return ~0ULL;
+
+    uint64_t value = row[word];
+    int used = width - (int)word * 64;
+    if (used < 64) value |= ~0ULL << used;
+    return value;
+}
+
+// Adds one bit plane to a 4-bit counter held in s0..s3 (ripple carry, 64 counters at once)
+static inline void AddBits(uint64_t* s0, uint64_t* s1, uint64_t* s2, uint64_t* s3, uint64_t bits) {
+    uint64_t carry = *s0 & bits;
+    *s0 ^= bits;
+    uint64_t carry2 = *s1 & carry;
+    *s1 ^= carry;
+    *s3 |= *s2 & carry2;
+    *s2 ^= carry2;
+}
+
+// Sliding window over one row: the previous, current and next words, each loaded once
+typedef struct {
+    const uint64_t* row;
+    uint64_t previous, current, next;
+} RowWindow;
+
+static inline void StartRow(RowWindow* window, const uint64_t* row, size_t stride, int width) {
+    window->row = row;
+    window->previous = ~0ULL;
+    window->current = LoadWord(row, 0, stride, width);
+    window->next = LoadWord(row, 1, stride, width);
+}
+
+static inline void AdvanceRow(RowWindow* window, size_t word, size_t stride, int width) {
+    window->previous = window->current;
+    window->current = window->next;
+    window->next = LoadWord(window->row, word + 2, stride, width);
+}
+
+// Adds the row neighbours of every bit of the current word, bit x gets tiles x - 1 and x + 1
+// (and x itself unless it is the center row)
+static inline void AddRow(uint64_t* s0, uint64_t* s1, uint64_t* s2, uint64_t* s3, const RowWindow* window, int center) {
+    AddBits(s0, s1, s2, s3, window->current << 1 | window->previous >> 63);
+    AddBits(s0, s1, s2, s3, window->current >> 1 | window->next << 63);
+    if (!center) AddBits(s0, s1, s2, s3, window->current);
+}
+
+void StepCaveAutomaton(const uint64_t* src, uint64_t* dst, size_t stride, int width, int height,
+                       int start_row, int end_row, CaveRules rules){
+    uint16_t any = rules.birth | rules.survival;
+
+    for (int y = start_row; y < end_row; y++) {
+        RowWindow above, row, below;
+        StartRow(&above, y > 0 ? src + (size_t)(y - 1) * stride : NULL, stride, width);
+        StartRow(&row, src + (size_t)y * stride, stride, width);
+        StartRow(&below, y + 1 < height ? src + (size_t)(y + 1) * stride : NULL, stride, width);
+
+        for (size_t word = 0; word < stride; word++) {
+            uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+            AddRow(&s0, &s1, &s2, &s3, &above, 0);
+            AddRow(&s0, &s1, &s2, &s3, &row, 1);
+            AddRow(&s0, &s1, &s2, &s3, &below, 0);
+
+            uint64_t cell = row.current;
+            uint64_t born = 0, survived = 0;
+
+            for (int count = 0; count <= 8; count++) {
+                if (!(any >> count & 1)) continue;
+
+                uint64_t match = (count & 1 ? s0 : ~s0) & (count & 2 ? s1 : ~s1)
+                               & (count & 4 ? s2 : ~s2) & (count & 8 ? s3 : ~s3);
+                if (rules.birth >> count & 1) born |= match;
+                if (rules.survival >> count & 1) survived |= match;
+            }
+
+            uint64_t result = (~cell & born) | (cell & survived);
+            int used = width - (int)word * 64;
+            dst[(size_t)y * stride + word] = used < 64 ? result & ~(~0ULL << used) : result; // Padding stays clear
+
+            AdvanceRow(&above, word, stride, width);
+            AdvanceRow(&row, word, stride, width);
+            AdvanceRow(&below, word, stride, width);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AUTOMATA_H
+#define AUTOMATA_H
+//
+#include <stdint.h>
+#include <stddef.h>
+//
+// Cellular automata smoothing of the caves. The map is held as a bit plane (1 = wall), rows
+// padded to whole 64-bit words, and the 8 neighbour counts of a whole word are computed at
+// once with bit-sliced adders, so one step costs a few dozen word operations per 64 tiles.
+// Tiles outside the plane count as walls.
+//
+#define CAVE_RULE(n) (1u << (n)) // Neighbour count n, in CaveRules.birth and CaveRules.survival
+//
+typedef struct {
+    int iterations;         // Steps to run, 0 disables the stage (the old cleanup pass runs instead)
+    uint16_t birth;         // CAVE_RULE(n) set: a floor with n wall neighbours becomes a wall
+    uint16_t survival;      // CAVE_RULE(n) set: a wall with n wall neighbours stays a wall
+} CaveRules;
+
+// B5678/S45678, walls fill in where most neighbours are walls and erode where few are
+#define CAVE_DEFAULT_ITERATIONS 3
+#define CAVE_DEFAULT_BIRTH (CAVE_RULE(5) | CAVE_RULE(6) | CAVE_RULE(7) | CAVE_RULE(8))
+#define CAVE_DEFAULT_SURVIVAL (CAVE_RULE(4) | CAVE_RULE(5) | CAVE_RULE(6) | CAVE_RULE(7) | CAVE_RULE(8))
+
+#define CAVE_MAX_CHUNK_ITERATIONS 15 // A chunk, the tile around it and the apron must fit in one word per row
+//
+//====== automata.c ================================================================================//
+//
+// Rules used by the generator, the same for every thread. Changing them changes every map
+void SetCaveRules(CaveRules rules);
+CaveRules GetCaveRules(void);
+uint32_t PackCaveRules(CaveRules rules); // For cache keys
+//
+// One step for the rows [start_row, end_row) of a width x height plane, src and dst are
+// stride words per row and must not overlap
+void StepCaveAutomaton(const uint64_t* src, uint64_t* dst, size_t stride, int width, int height,
+                       int start_row, int end_row, CaveRules rules);
+//
+//==================================================================================================//
+//
+#endif // AUTOMATA_H
@@ -0,0 +1,72 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "autotile.h"
+
+// Only the west and east neighbours pick a piece with the current tileset, the other bits are
+// there for tilesets with corner pieces
+#define WALL_SHAPE(mask) ((((mask) & WALL_NEIGHBOR_W) && !((mask) & WALL_NEIGHBOR_E)) ? WALL_SHAPE_LEFT : \
+                          (!((mask) & WALL_NEIGHBOR_W) && ((mask) & WALL_NEIGHBOR_E)) ? WALL_SHAPE_RIGHT : WALL_SHAPE_MID)
+#define WALL_SHAPES_4(mask)  WALL_SHAPE(mask), WALL_SHAPE((mask) + 1), WALL_SHAPE((mask) + 2), WALL_SHAPE((mask) + 3)
+#define WALL_SHAPES_16(mask) WALL_SHAPES_4(mask), WALL_SHAPES_4((mask) + 4), WALL_SHAPES_4((mask) + 8), WALL_SHAPES_4((mask) + 12)
+#define WALL_SHAPES_64(mask) WALL_SHAPES_16(mask), WALL_SHAPES_16((mask) + 16), WALL_SHAPES_16((mask) + 32), WALL_SHAPES_16((mask) + 48)
+
+const uint8_t WallShapes[256] = {
+    WALL_SHAPES_64(0), WALL_SHAPES_64(64), WALL_SHAPES_64(128), WALL_SHAPES_64(192)
+};
+
+// Word of the plane, everything outside of it reads as walls
+static inline uint64_t PlaneWord(const uint64_t* plane, size_t stride, int height, int y, ptrdiff_t word, uint64_t padding){
+    if (y < 0 || y >= height || word < 0 || (size_t)word >= stride) return ~0ULL;
+    uint64_t bits = plane[(size_t)y * stride + (size_t)word];
+    return (size_t)word == stride - 1 ? bits | padding : bits;
+}
+
+int GetWallMasks(const uint64_t* plane, size_t stride, int width, int height, int y, int* columns, uint8_t* masks){
+    int tail = width & 63;
+    uint64_t padding = tail ? ~0ULL << tail : 0; // Columns after the last one in the last word
+    int count = 0;
+
+    for (ptrdiff_t word = 0; (size_t)word < stride; word++) {
+        uint64_t center[3], west[3], east[3]; // Rows y - 1, y and y + 1
+
+        for (int row = 0; row < 3; row++) {
+            uint64_t previous = PlaneWord(plane, stride, height, y + row - 1, word - 1, padding);
+            uint64_t current = PlaneWord(plane, stride, height, y + row - 1, word, padding);
+            uint64_t next = PlaneWord(plane, stride, height, y + row - 1, word + 1, padding);
+
+            center[row] = current;
+            west[row] = (current << 1) | (previous >> 63); // Bit x holds the tile at x - 1
+            east[row] = (current >> 1) | (next << 63);     // Bit x holds the tile at x + 1
+        }
+
+        uint64_t closed = center[0] & east[0] & east[1] & east[2] & center[2] & west[2] & west[1] & west[0];
+        uint64_t walls = center[1] & ~((size_t)word == stride - 1 ? padding : 0);
+
+        for (uint64_t open = walls & ~closed; open != 0; open &= open - 1) {
+            int bit = __builtin_ctzll(open);
+
+            columns[count] = (int)word * 64 + bit;
+            masks[count] = (uint8_t)(((center[0] >> bit) & 1) | ((east[0] >> bit) & 1) << 1 | ((east[1] >> bit) & 1) << 2 |
+                                     ((east[2] >> bit) & 1) << 3 | ((center[2] >> bit) & 1) << 4 | ((west[2] >> bit) & 1) << 5 |
+                                     ((west[1] >> bit) & 1) << 6 | ((west[0] >> bit) & 1) << 7);
+            count++;
+        }
+    }
+
+    return count;
+}
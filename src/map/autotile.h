@@ -0,0 +1,56 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef AUTOTILE_H
+#define AUTOTILE_H
+//
+#include <stdint.h>
+#include <stddef.h>
+//
+// Wall autotiling. Every wall gets an 8 bit mask of its blocking neighbours, read from the
+// blocking plane 64 tiles at a time, and the mask picks the wall piece through WallShapes.
+// Tiles outside the plane count as walls, so the map borders come out of the same table.
+//
+typedef enum {
+    WALL_NEIGHBOR_N  = 1 << 0,
+    WALL_NEIGHBOR_NE = 1 << 1,
+    WALL_NEIGHBOR_E  = 1 << 2,
+    WALL_NEIGHBOR_SE = 1 << 3,
+    WALL_NEIGHBOR_S  = 1 << 4,
+    WALL_NEIGHBOR_SW = 1 << 5,
+    WALL_NEIGHBOR_W  = 1 << 6,
+    WALL_NEIGHBOR_NW = 1 << 7,
+} WallNeighbor;
+
+typedef enum {
+    WALL_SHAPE_MID,         // Inside a run of walls, keeps its variant (banners, holes)
+    WALL_SHAPE_LEFT,        // Left side of an open area: wall to the west, open to the east
+    WALL_SHAPE_RIGHT,       // Right side of an open area: open to the west, wall to the east
+} WallShape;
+//
+//====== autotile.c ================================================================================//
+//
+extern const uint8_t WallShapes[256]; // WallShape of every neighbour mask, built at compile time
+//
+// Finds the walls of row y of a width x height plane (stride words per row) that have at least
+// one open neighbour, the only ones that can be something other than WALL_SHAPE_MID. Writes
+// their column to columns and their neighbour mask to masks, returns how many there are
+int GetWallMasks(const uint64_t* plane, size_t stride, int width, int height, int y, int* columns, uint8_t* masks);
+//
+//==================================================================================================//
+//
+#endif // AUTOTILE_H
@@ -0,0 +1,211 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "bsp.h"
+#include <string.h>
+
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} BspRect;
+
+typedef struct {
+    int x;
+    int y;
+} BspPoint;
+
+// Area being carved
+typedef struct {
+    uint8_t floor;
+    int sectors_x;
+    int sectors_y;
+    int x0;
+    int y0;
+    int w;
+    int h;
+    uint8_t* tiles;
+    int stride;
+} BspCanvas;
+
+// Salt 0 is the split, 1 the room of a leaf and 2 the links of the node
+static uint32_t NodeHash(uint32_t sector_seed, uint32_t node, int salt){
+    return RngHash2D(sector_seed, RNG_STREAM_ROOMS, (int)node, salt);
+}
+
+static bool Overlaps(const BspCanvas* canvas, BspRect rect){
+    return rect.x < canvas->x0 + canvas->w && rect.x + rect.w > canvas->x0
+        && rect.y < canvas->y0 + canvas->h && rect.y + rect.h > canvas->y0;
+}
+
+static void CarveRect(const BspCanvas* canvas, BspRect rect){
+    int x0 = rect.x > canvas->x0 ? rect.x : canvas->x0;
+    int y0 = rect.y > canvas->y0 ? rect.y : canvas->y0;
+    int x1 = rect.x + rect.w < canvas->x0 + canvas->w ? rect.x + rect.w : canvas->x0 + canvas->w;
+    int y1 = rect.y + rect.h < canvas->y0 + canvas->h ? rect.y + rect.h : canvas->y0 + canvas->h;
+    if (x0 >= x1) return;
+
+    for (int y = y0; y < y1; y++)
+        memset(&canvas->tiles[(y - canvas->y0) * canvas->stride + (x0 - canvas->x0)], canvas->floor, (size_t)(x1 - x0));
+}
+
+// L shaped, inside the bounding box of its ends
+static void CarveCorridor(const BspCanvas* canvas, BspPoint from, BspPoint to, bool horizontal_first){
+    int left = from.x < to.x ? from.x : to.x, top = from.y < to.y ? from.y : to.y;
+    int w = abs(to.x - from.x) + 1, h = abs(to.y - from.y) + 1;
+
+    if (horizontal_first) {
+        CarveRect(canvas, (BspRect){left, from.y, w, 1});
+        CarveRect(canvas, (BspRect){to.x, top, 1, h});
+    } else {
+        CarveRect(canvas, (BspRect){from.x, top, 1, h});
+        CarveRect(canvas, (BspRect){left, to.y, w, 1});
+    }
+}
+
+// Splits rect in two along its longest side, returns false for leaves
+static bool SplitNode(uint32_t hash, BspRect rect, BspRect* first, BspRect* second){
+    bool can_split_x = rect.w >= 2 * BSP_MIN_LEAF, can_split_y = rect.h >= 2 * BSP_MIN_LEAF;
+    if (!can_split_x && !can_split_y) return false;
+
+    bool split_x = can_split_x && (!can_split_y || rect.w * 4 > rect.h * 5 || (rect.h * 4 <= rect.w * 5 && (hash & 1)));
+    int size = split_x ? rect.w : rect.h;
+    int cut = BSP_MIN_LEAF + (int)((hash >> 1) % (uint32_t)(size - 2 * BSP_MIN_LEAF + 1));
+
+    *first = rect;
+    *second = rect;
+    if (split_x) {
+        first->w = cut;
+        second->x += cut;
+        second->w -= cut;
+    } else {
+        first->h = cut;
+        second->y += cut;
+        second->h -= cut;
+    }
+    return true;
+}
+
+// Room of a leaf, one tile in from its edges so two rooms never touch
+static BspRect LeafRoom(uint32_t hash, BspRect leaf){
+    int space_w = leaf.w - 2 > 1 ? leaf.w - 2 : 1;
+    int space_h = leaf.h - 2 > 1 ? leaf.h - 2 : 1;
+    int room_w = space_w < BSP_MIN_ROOM ? space_w : BSP_MIN_ROOM + (int)(hash % (uint32_t)(space_w - BSP_MIN_ROOM + 1));
+    int room_h = space_h < BSP_MIN_ROOM ? space_h : BSP_MIN_ROOM + (int)((hash >> 8) % (uint32_t)(space_h - BSP_MIN_ROOM + 1));
+
+    return (BspRect){
+        leaf.x + 1 + (int)((hash >> 16) % (uint32_t)(space_w - room_w + 1)),
+        leaf.y + 1 + (int)((hash >> 24) % (uint32_t)(space_h - room_h + 1)),
+        room_w, room_h
+    };
+}
+
+static BspPoint RoomCenter(BspRect room){
+    return (BspPoint){room.x + room.w / 2, room.y + room.h / 2};
+}
+
+// Where the corridors of the node end: the center of a room of its subtree. Children of node n
+// are 2n and 2n + 1, the root is 1
+static BspPoint NodeAnchor(uint32_t sector_seed, BspRect rect, uint32_t node){
+    BspRect children[2];
+    uint32_t hash = NodeHash(sector_seed, node, 0);
+
+    while (SplitNode(hash, rect, &children[0], &children[1])) {
+        int pick = (int)(NodeHash(sector_seed, node, 2) & 1);
+        rect = children[pick];
+        node = 2 * node + (uint32_t)pick;
+        hash = NodeHash(sector_seed, node, 0);
+    }
+
+    return RoomCenter(LeafRoom(NodeHash(sector_seed, node, 1), rect));
+}
+
+// Carves the rooms and corridors of the subtree that fall in the canvas, returns its anchor
+static BspPoint CarveNode(const BspCanvas* canvas, uint32_t sector_seed, BspRect rect, uint32_t node){
+    if (!Overlaps(canvas, rect)) return NodeAnchor(sector_seed, rect, node);
+
+    BspRect children[2];
+    uint32_t hash = NodeHash(sector_seed, node, 0);
+
+    if (!SplitNode(hash, rect, &children[0], &children[1])) {
+        BspRect room = LeafRoom(NodeHash(sector_seed, node, 1), rect);
+        CarveRect(canvas, room);
+        return RoomCenter(room);
+    }
+
+    uint32_t links = NodeHash(sector_seed, node, 2);
+    BspPoint first = CarveNode(canvas, sector_seed, children[0], 2 * node);
+    BspPoint second = CarveNode(canvas, sector_seed, children[1], 2 * node + 1);
+    CarveCorridor(canvas, first, second, (links >> 1) & 1);
+
+    return (links & 1) ? second : first;
+}
+
+static BspRect SectorRect(const BspCanvas* canvas, int width, int height, int sector_x, int sector_y){
+    int x = sector_x * BSP_SECTOR_SIZE, y = sector_y * BSP_SECTOR_SIZE;
+    int end_x = sector_x == canvas->sectors_x - 1 ? width : x + BSP_SECTOR_SIZE;
+    int end_y = sector_y == canvas->sectors_y - 1 ? height : y + BSP_SECTOR_SIZE;
+    return (BspRect){x, y, end_x - x, end_y - y};
+}
+
+static int SectorOf(int coordinate, int sectors){
+    int sector = coordinate < 0 ? 0 : coordinate / BSP_SECTOR_SIZE;
+    return sector < sectors ? sector : sectors - 1;
+}
+
+void CarveBspRooms(uint32_t seed, int width, int height, int x0, int y0, int w, int h, uint8_t* tiles, int stride){
+    BspCanvas canvas = {
+        .floor = GetCaveTile(seed, 0, 0, true),
+        .sectors_x = width / BSP_SECTOR_SIZE > 1 ? width / BSP_SECTOR_SIZE : 1,
+        .sectors_y = height / BSP_SECTOR_SIZE > 1 ? height / BSP_SECTOR_SIZE : 1,
+        .x0 = x0, .y0 = y0, .w = w, .h = h,
+        .tiles = tiles,
+        .stride = stride,
+    };
+
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            tiles[y * stride + x] = GetCaveTile(seed, x0 + x, y0 + y, false);
+
+    // Corridors reach into the squares on the right and below, so the squares before the
+    // area are carved too
+    int first_x = SectorOf(x0, canvas.sectors_x) - 1, last_x = SectorOf(x0 + w - 1, canvas.sectors_x);
+    int first_y = SectorOf(y0, canvas.sectors_y) - 1, last_y = SectorOf(y0 + h - 1, canvas.sectors_y);
+    BspPoint spawn = {width / 2, height / 2};
+
+    for (int sector_y = first_y > 0 ? first_y : 0; sector_y <= last_y; sector_y++)
+        for (int sector_x = first_x > 0 ? first_x : 0; sector_x <= last_x; sector_x++) {
+            BspRect rect = SectorRect(&canvas, width, height, sector_x, sector_y);
+            uint32_t sector_seed = RngHash2D(seed, RNG_STREAM_ROOMS, sector_x, sector_y);
+            BspPoint anchor = CarveNode(&canvas, sector_seed, rect, 1);
+
+            if (sector_x + 1 < canvas.sectors_x) {
+                BspRect next = SectorRect(&canvas, width, height, sector_x + 1, sector_y);
+                BspPoint to = NodeAnchor(RngHash2D(seed, RNG_STREAM_ROOMS, sector_x + 1, sector_y), next, 1);
+                CarveCorridor(&canvas, anchor, to, true);
+            }
+            if (sector_y + 1 < canvas.sectors_y) {
+                BspRect next = SectorRect(&canvas, width, height, sector_x, sector_y + 1);
+                BspPoint to = NodeAnchor(RngHash2D(seed, RNG_STREAM_ROOMS, sector_x, sector_y + 1), next, 1);
+                CarveCorridor(&canvas, anchor, to, false);
+            }
+
+            // Sideways first, the ladder is right above the spawn point
+            if (spawn.x >= rect.x && spawn.x < rect.x + rect.w && spawn.y >= rect.y && spawn.y < rect.y + rect.h)
+                CarveCorridor(&canvas, spawn, anchor, true);
+        }
+}
@@ -0,0 +1,45 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BSP_H
+#define BSP_H
+//
+#include "maps.h"
+//
+// Room and corridor layouts. The map is cut in BSP_SECTOR_SIZE squares (the last row and column
+// take what is left), the top levels of the tree. Every square is split again in two, along its
+// longest side, until the parts are under 2 * BSP_MIN_LEAF tiles. Every leaf holds a room, and
+// the two halves of every split are joined by a corridor between a room of each. Corridors also
+// join every square to the squares on its right and below it, and the spawn point to its square,
+// so the whole map is one region and needs no cleanup.
+//
+// Every split and room is hashed from (seed, square, node), nothing is stored: any area of the
+// map can be carved on its own, subtrees away from it are skipped and only the path to the room
+// its corridors end at is walked. Flat maps carve row bands in parallel, streamed maps a chunk.
+//
+#define BSP_SECTOR_SIZE 64  // Tiles per side of the top level squares
+#define BSP_MIN_LEAF 10     // Leaves are at least this wide and tall, when the square is
+#define BSP_MIN_ROOM 4      // Rooms are at least this wide and tall, when the leaf is
+//
+//====== bsp.c =====================================================================================//
+//
+// Walls and rooms of the w x h tiles at (x0, y0) of a width x height map, into tiles (rows stride
+// tiles apart). The area can go past the edges of the map, those tiles are walls
+void CarveBspRooms(uint32_t seed, int width, int height, int x0, int y0, int w, int h, uint8_t* tiles, int stride);
+//
+//==================================================================================================//
+//
+#endif // BSP_H
@@ -0,0 +1,302 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "chunks.h"
+#include "maps.h" // TileProperties
+
+// Indices of the chunks made of a single tile, all of them point here
+static uint32_t uniform_indices[CHUNK_TILES / 32];
+
+static size_t HashChunk(int chunk_x, int chunk_y) {
+    uint32_t h = (uint32_t)chunk_x * 0x9E3779B1u ^ (uint32_t)chunk_y * 0x85EBCA77u;
+    h ^= h >> 15;
+    return (size_t)h;
+}
+
+ChunkManager* InitChunkManager(uint32_t seed, int map_width, int map_height, size_t memory_budget){
+
+    ChunkManager* manager = (ChunkManager*)malloc(sizeof(ChunkManager));
+
+    // As many headers as uniform chunks fit in the budget. The pool is only touched as it is
+    // handed out, so the pages of headers that are never used are never committed
+    size_t max_chunks = memory_budget / sizeof(MapChunk);
+    if (max_chunks < 64) max_chunks = 64; // Always enough to cover the chunks around the camera
+
+    size_t bucket_count = 1;
+    while (bucket_count < max_chunks * 2) bucket_count <<= 1;
+
+    manager->map_width = map_width;
+    manager->map_height = map_height;
+    manager->max_chunks = max_chunks;
+    manager->memory_budget = memory_budget;
+    manager->lru_head = NULL;
+    manager->pool = (MapChunk*)malloc(max_chunks * sizeof(MapChunk));
+    manager->buckets = (MapChunk**)malloc(bucket_count * sizeof(MapChunk*));
+    manager->bucket_mask = bucket_count - 1;
+    manager->edits = NULL;
+    manager->edit_capacity = 0;
+
+    ResetChunkManager(manager, seed);
+
+    return manager;
+}
+
+// Drops every resident chunk, used when a new level is generated
+void ResetChunkManager(ChunkManager* manager, uint32_t seed){
+    for (MapChunk* chunk = manager->lru_head; chunk != NULL; chunk = chunk->lru_next)
+        if (chunk->indices != uniform_indices) free(chunk->indices);
+
+    manager->seed = seed;
+    InitNoise(&manager->noise, seed);
+    manager->rules = GetCaveRules();
+    manager->generator = GetMapGenerator();
+    manager->free_chunks = NULL;
+    manager->used_chunks = 0;
+    manager->resident_chunks = 0;
+    manager->resident_bytes = 0;
+    manager->lru_head = NULL;
+    manager->lru_tail = NULL;
+    manager->last_hit = NULL;
+    manager->edit_count = 0;
+    manager->generated_chunks = 0;
+    manager->evicted_chunks = 0;
+    memset(manager->buckets, 0, (manager->bucket_mask + 1) * sizeof(MapChunk*));
+}
+
+void FreeChunkManager(ChunkManager* manager){
+    if (manager == NULL) return;
+
+    for (MapChunk* chunk = manager->lru_head; chunk != NULL; chunk = chunk->lru_next)
+        if (chunk->indices != uniform_indices) free(chunk->indices);
+
+    free(manager->edits);
+    free(manager->buckets);
+    free(manager->pool);
+    free(manager);
+}
+
+static void UnlinkChunk(ChunkManager* manager, MapChunk* chunk){
+    if (chunk->lru_prev) chunk->lru_prev->lru_next = chunk->lru_next;
+    else manager->lru_head = chunk->lru_next;
+
+    if (chunk->lru_next) chunk->lru_next->lru_prev = chunk->lru_prev;
+    else manager->lru_tail = chunk->lru_prev;
+}
+
+static void PushChunkFront(ChunkManager* manager, MapChunk* chunk){
+    chunk->lru_prev = NULL;
+    chunk->lru_next = manager->lru_head;
+
+    if (manager->lru_head) manager->lru_head->lru_prev = chunk;
+    else manager->lru_tail = chunk;
+
+    manager->lru_head = chunk;
+}
+
+static void RemoveFromBucket(ChunkManager* manager, MapChunk* chunk){
+    MapChunk** slot = &manager->buckets[HashChunk(chunk->chunk_x, chunk->chunk_y) & manager->bucket_mask];
+
+    while (*slot != chunk) slot = &(*slot)->hash_next;
+    *slot = chunk->hash_next;
+}
+
+static size_t IndicesSize(unsigned index_shift){
+    return (size_t)CHUNK_TILES << index_shift >> 3;
+}
+
+static size_t ChunkBytes(const MapChunk* chunk){
+    return sizeof(MapChunk) + (chunk->indices == uniform_indices ? 0 : IndicesSize(chunk->index_shift));
+}
+
+static void EvictChunk(ChunkManager* manager){
+    MapChunk* chunk = manager->lru_tail;
+    UnlinkChunk(manager, chunk);
+    RemoveFromBucket(manager, chunk);
+    if (manager->last_hit == chunk) manager->last_hit = NULL;
+
+    manager->resident_bytes -= ChunkBytes(chunk);
+    if (chunk->indices != uniform_indices) free(chunk->indices);
+
+    chunk->hash_next = manager->free_chunks;
+    manager->free_chunks = chunk;
+    manager->resident_chunks--;
+    manager->evicted_chunks++;
+}
+
+// Takes a free header from the pool, evicting the least recently used chunk if there is none
+static MapChunk* AcquireChunk(ChunkManager* manager){
+    if (manager->free_chunks == NULL && manager->used_chunks == manager->max_chunks) EvictChunk(manager);
+
+    MapChunk* chunk;
+    if (manager->free_chunks != NULL) {
+        chunk = manager->free_chunks;
+        manager->free_chunks = chunk->hash_next;
+    } else {
+        chunk = &manager->pool[manager->used_chunks++];
+    }
+
+    chunk->indices = uniform_indices;
+    chunk->index_shift = 0;
+    manager->resident_chunks++;
+    manager->resident_bytes += sizeof(MapChunk);
+
+    return chunk;
+}
+
+// Rebuilds the palette and the indices of the chunk from its CHUNK_TILES tiles
+void PackChunk(ChunkManager* manager, MapChunk* chunk, const uint8_t* tiles){
+    uint8_t slot[256]; // Palette index of every tile id, CHUNK_PALETTE_MAX when unused
+    memset(slot, CHUNK_PALETTE_MAX, sizeof(slot));
+
+    chunk->palette_count = 0;
+    for (int i = 0; i < CHUNK_TILES; i++) {
+        if (slot[tiles[i]] != CHUNK_PALETTE_MAX) continue;
+
+        slot[tiles[i]] = chunk->palette_count;
+        chunk->palette[chunk->palette_count++] = tiles[i];
+    }
+
+    unsigned shift = chunk->palette_count <= 2 ? 0 : chunk->palette_count <= 4 ? 1 : chunk->palette_count <= 16 ? 2 : 3;
+
+    manager->resident_bytes -= ChunkBytes(chunk);
+    if (chunk->indices != uniform_indices) free(chunk->indices);
+
+    chunk->index_shift = (uint8_t)shift;
+    if (chunk->palette_count == 1) {
+        chunk->indices = uniform_indices;
+    } else {
+        chunk->indices = (uint32_t*)calloc(1, IndicesSize(shift));
+        for (size_t i = 0; i < CHUNK_TILES; i++)
+            chunk->indices[i >> (5 - shift)] |= (uint32_t)slot[tiles[i]] << ((i << shift) & 31);
+    }
+
+    manager->resident_bytes += ChunkBytes(chunk);
+}
+
+// Writes one tile, growing the palette (and the indices, when they get too narrow) if needed
+void SetChunkTile(ChunkManager* manager, MapChunk* chunk, size_t index, uint8_t tile){
+    uint32_t entry = 0;
+    while (entry < chunk->palette_count && chunk->palette[entry] != tile) entry++;
+
+    if (chunk->indices == uniform_indices || entry >= CHUNK_PALETTE_MAX || entry >= (1u << (1u << chunk->index_shift))) {
+        uint8_t tiles[CHUNK_TILES];
+        DecodeChunkTiles(chunk, 0, CHUNK_TILES, tiles);
+        tiles[index] = tile;
+        PackChunk(manager, chunk, tiles);
+        return;
+    }
+
+    if (entry == chunk->palette_count) chunk->palette[chunk->palette_count++] = tile;
+
+    unsigned shift = chunk->index_shift;
+    uint32_t* word = &chunk->indices[index >> (5 - shift)];
+    unsigned offset = (unsigned)(index << shift) & 31;
+    uint32_t mask = ((1u << (1u << shift)) - 1) << offset;
+    *word = (*word & ~mask) | (entry << offset);
+}
+
+// Later edits of the same tile replace the earlier one. The log only grows with the tiles the
+// player changes, so a linear search is enough
+void RecordChunkEdit(ChunkManager* manager, int x, int y, uint8_t tile){
+    for (size_t i = 0; i < manager->edit_count; i++) {
+        if (manager->edits[i].x != x || manager->edits[i].y != y) continue;
+
+        manager->edits[i].tile = tile;
+        return;
+    }
+
+    if (manager->edit_count == manager->edit_capacity) {
+        manager->edit_capacity = manager->edit_capacity ? manager->edit_capacity * 2 : 64;
+        manager->edits = (ChunkEdit*)realloc(manager->edits, sizeof(ChunkEdit) * manager->edit_capacity);
+    }
+
+    manager->edits[manager->edit_count++] = (ChunkEdit){ x, y, tile };
+}
+
+// Puts the logged edits of a chunk back over its generated tiles
+static void ApplyChunkEdits(const ChunkManager* manager, MapChunk* chunk, uint8_t* tiles){
+    for (size_t i = 0; i < manager->edit_count; i++) {
+        const ChunkEdit* edit = &manager->edits[i];
+        if ((edit->x >> CHUNK_SHIFT) != chunk->chunk_x || (edit->y >> CHUNK_SHIFT) != chunk->chunk_y) continue;
+
+        uint32_t bit = 1u << (edit->x & CHUNK_MASK);
+        uint32_t blocking = TileProperties[edit->tile] & TILE_FLAG_BLOCKING;
+        uint32_t* row = &chunk->blocking[edit->y & CHUNK_MASK];
+
+        tiles[ChunkTileIndex(edit->x, edit->y)] = edit->tile;
+        *row = (*row & ~bit) | (blocking << (edit->x & CHUNK_MASK));
+    }
+}
+
+// Returns the chunk at (chunk_x, chunk_y), generating it if it is not resident
+MapChunk* LoadChunk(ChunkManager* manager, int chunk_x, int chunk_y){
+    size_t bucket = HashChunk(chunk_x, chunk_y) & manager->bucket_mask;
+
+    for (MapChunk* chunk = manager->buckets[bucket]; chunk != NULL; chunk = chunk->hash_next) {
+        if (chunk->chunk_x != chunk_x || chunk->chunk_y != chunk_y) continue;
+
+        if (chunk != manager->lru_head) {
+            UnlinkChunk(manager, chunk);
+            PushChunkFront(manager, chunk);
+        }
+
+        manager->last_hit = chunk;
+        return chunk;
+    }
+
+    MapChunk* chunk = AcquireChunk(manager);
+    uint8_t tiles[CHUNK_TILES];
+    chunk->chunk_x = chunk_x;
+    chunk->chunk_y = chunk_y;
+    GenerateChunk(manager, chunk, tiles);
+    ApplyChunkEdits(manager, chunk, tiles);
+    PackChunk(manager, chunk, tiles);
+    manager->generated_chunks++;
+
+    chunk->hash_next = manager->buckets[bucket];
+    manager->buckets[bucket] = chunk;
+    PushChunkFront(manager, chunk);
+
+    // The new chunk is at the front, it is never the one evicted
+    while (manager->resident_bytes > manager->memory_budget && manager->lru_tail != chunk) EvictChunk(manager);
+
+    manager->last_hit = chunk;
+    return chunk;
+}
+
+// Called once per frame, makes sure the chunks around the camera are generated before
+// the player reaches them, so the generation cost is spread over the frames
+void StreamChunksAround(ChunkManager* manager, Vector2 target){
+    int center_x = (int)(target.x / __TILE_SIZE) >> CHUNK_SHIFT;
+    int center_y = (int)(target.y / __TILE_SIZE) >> CHUNK_SHIFT;
+    int last_chunk_x = (manager->map_width - 1) >> CHUNK_SHIFT;
+    int last_chunk_y = (manager->map_height - 1) >> CHUNK_SHIFT;
+
+    center_x = (center_x < 0) ? 0 : (center_x > last_chunk_x) ? last_chunk_x : center_x;
+    center_y = (center_y < 0) ? 0 : (center_y > last_chunk_y) ? last_chunk_y : center_y;
+
+    for (int chunk_y = center_y - CHUNK_PREFETCH_RADIUS; chunk_y <= center_y + CHUNK_PREFETCH_RADIUS; chunk_y++) {
+        if (chunk_y < 0 || chunk_y > last_chunk_y) continue;
+
+        for (int chunk_x = center_x - CHUNK_PREFETCH_RADIUS; chunk_x <= center_x + CHUNK_PREFETCH_RADIUS; chunk_x++) {
+            if (chunk_x < 0 || chunk_x > last_chunk_x) continue;
+            LoadChunk(manager, chunk_x, chunk_y);
+        }
+    }
+
+    // Leave the camera chunk as the most recently used one
+    LoadChunk(manager, center_x, center_y);
+}
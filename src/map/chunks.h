@@ -0,0 +1,150 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CHUNKS_H
+#define CHUNKS_H
+//
+#include "../defs.h"
+#include "../structs.h"
+#include "noise.h"
+#include "automata.h"
+//
+// Maps bigger than MAP_STREAMING_THRESHOLD are not generated up front. They are split in
+// CHUNK_SIZE x CHUNK_SIZE chunks that are generated when the camera gets close to them
+// (or when something reads a tile inside them) and evicted, least recently used first,
+// once the resident chunks go over the memory budget.
+//
+// The tiles of a chunk are palette compressed: the chunk keeps the list of tile ids it uses and
+// a 1, 2, 4 or 8 bit index into that list per tile, picked from the palette size. Chunks made
+// of a single tile share a block of zero indices, so they cost only their header.
+//
+#define MAP_STREAMING_THRESHOLD 500
+#define CHUNK_SHIFT 5
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)       // 32x32 tiles per chunk
+#define CHUNK_MASK (CHUNK_SIZE - 1)
+#define CHUNK_TILES (CHUNK_SIZE * CHUNK_SIZE)
+#define CHUNK_MEMORY_BUDGET (8 * 1024 * 1024) // Default budget, in bytes, for resident chunks
+#define CHUNK_PREFETCH_RADIUS 2               // Chunks kept ready around the camera chunk
+#define CHUNK_PALETTE_MAX 32                  // Palette entries of a chunk, more than there are tile types
+//
+typedef struct MapChunk MapChunk;
+
+// Tile changed while playing, put back whenever its chunk is generated again
+typedef struct {
+    int32_t x;
+    int32_t y;
+    uint8_t tile;
+} ChunkEdit;
+
+struct MapChunk{
+    int chunk_x;            // Chunk coordinates, in chunks (tile_x >> CHUNK_SHIFT)
+    int chunk_y;
+    uint32_t* indices;      // Palette index of every tile (same order as MapNode.tiles), 1 << index_shift bits each
+    uint8_t index_shift;    // 0 to 3
+    uint8_t palette_count;
+    uint8_t palette[CHUNK_PALETTE_MAX]; // Tile ids used by the chunk
+    uint32_t blocking[CHUNK_SIZE]; // One word per row, bit x set for blocking tiles
+    MapChunk* lru_prev;     // Towards the most recently used chunk
+    MapChunk* lru_next;     // Towards the least recently used chunk
+    MapChunk* hash_next;    // Next chunk in the same hash bucket
+};
+
+struct ChunkManager{
+    uint32_t seed;          // Seed of the level, every chunk is generated from (seed, chunk_x, chunk_y)
+    NoiseContext noise;     // Noise of the level, shared by every chunk
+    CaveRules rules;        // Smoothing rules the level was started with
+    int generator;          // MapGeneratorId the level was started with
+    int map_width;          // Size of the whole map, in tiles
+    int map_height;
+    MapChunk* pool;         // Chunk headers, reserved up front and handed out in order
+    MapChunk* free_chunks;  // Headers of evicted chunks, linked through hash_next
+    MapChunk** buckets;     // Hash table of the resident chunks
+    size_t bucket_mask;
+    size_t max_chunks;      // Headers in the pool
+    size_t used_chunks;     // Headers handed out at least once
+    size_t resident_chunks;
+    size_t memory_budget;   // In bytes, headers and indices of the resident chunks
+    size_t resident_bytes;
+    MapChunk* lru_head;     // Most recently used chunk
+    MapChunk* lru_tail;     // Least recently used chunk, first to be evicted
+    MapChunk* last_hit;     // Last chunk returned, most lookups hit the same chunk again
+    ChunkEdit* edits;       // Edit log of the level, one entry per changed tile, not in the budget
+    size_t edit_count;
+    size_t edit_capacity;
+    unsigned long generated_chunks; // Stats, shown in debug builds
+    unsigned long evicted_chunks;
+};
+//
+//====== chunks.c ==================================================================================//
+//
+ChunkManager* InitChunkManager(uint32_t seed, int map_width, int map_height, size_t memory_budget);
+void ResetChunkManager(ChunkManager* manager, uint32_t seed);
+void FreeChunkManager(ChunkManager* manager);
+MapChunk* LoadChunk(ChunkManager* manager, int chunk_x, int chunk_y);
+void PackChunk(ChunkManager* manager, MapChunk* chunk, const uint8_t* tiles);
+void SetChunkTile(ChunkManager* manager, MapChunk* chunk, size_t index, uint8_t tile);
+void RecordChunkEdit(ChunkManager* manager, int x, int y, uint8_t tile);
+void StreamChunksAround(ChunkManager* manager, Vector2 target);
+//
+//====== map_generator.c ===========================================================================//
+//
+void GenerateChunk(ChunkManager* manager, MapChunk* chunk, uint8_t* tiles); // Fills tiles (CHUNK_TILES) and chunk->blocking
+//
+//==================================================================================================//
+//
+// Fast path used by the tile accessors in maps.h
+static inline MapChunk* GetChunk(ChunkManager* manager, int x, int y) {
+    MapChunk* chunk = manager->last_hit;
+    if (chunk != NULL && chunk->chunk_x == (x >> CHUNK_SHIFT) && chunk->chunk_y == (y >> CHUNK_SHIFT))
+        return chunk;
+
+    return LoadChunk(manager, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT);
+}
+
+static inline size_t ChunkTileIndex(int x, int y) {
+    return (size_t)((y & CHUNK_MASK) << CHUNK_SHIFT | (x & CHUNK_MASK));
+}
+
+static inline uint32_t GetChunkIndex(const MapChunk* chunk, size_t index) {
+    unsigned shift = chunk->index_shift;
+    uint32_t word = chunk->indices[index >> (5 - shift)];
+    return (word >> ((index << shift) & 31)) & ((1u << (1u << shift)) - 1);
+}
+
+static inline uint8_t GetChunkTile(const MapChunk* chunk, size_t index) {
+    return chunk->palette[GetChunkIndex(chunk, index)];
+}
+
+// Decodes count tiles of the chunk starting at index, a word of indices at a time
+static inline void DecodeChunkTiles(const MapChunk* chunk, size_t index, int count, uint8_t* out) {
+    unsigned shift = chunk->index_shift;
+    unsigned bits = 1u << shift;
+    uint32_t mask = (1u << bits) - 1;
+
+    while (count > 0) {
+        unsigned offset = (unsigned)(index << shift) & 31;
+        uint32_t word = chunk->indices[index >> (5 - shift)] >> offset;
+        int run = (int)((32 - offset) >> shift);
+        if (run > count) run = count;
+
+        for (int i = 0; i < run; i++, word >>= bits) *out++ = chunk->palette[word & mask];
+
+        index += (size_t)run;
+        count -= run;
+    }
+}
+//
+#endif // CHUNKS_H
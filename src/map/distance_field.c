@@ -0,0 +1,132 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "distance_field.h"
+
+// Distance of a tile the pass does not change: out of the map (a wall) or out of the window
+static inline int FixedDistance(const MapNode* TileMap, int x, int y){
+    return IsInsideMap(TileMap, x, y) ? TileMap->distance[TileIndex(TileMap, x, y)] : 0;
+}
+
+static inline uint8_t Relax(int distance, int candidate){
+    if (candidate < distance) distance = candidate;
+    return (uint8_t)(distance > DISTANCE_MAX ? DISTANCE_MAX : distance);
+}
+
+// Takes the three tiles of row done_y next to (x, row), for the first and last columns of the
+// map, one of their neighbours is out of it
+static void RelaxEdgeColumn(const MapNode* TileMap, uint8_t* row, int x, int done_y){
+    int left = FixedDistance(TileMap, x - 1, done_y), right = FixedDistance(TileMap, x + 1, done_y);
+    int diagonal = (left < right ? left : right) + DISTANCE_DIAGONAL;
+    int straight = FixedDistance(TileMap, x, done_y) + DISTANCE_STEP;
+    row[x] = Relax(row[x], diagonal < straight ? diagonal : straight);
+}
+
+// One pass of the chamfer transform over the rows of [x0, x1] x [y0, y1], top to bottom and left
+// to right (forward) or the other way around. Each row first takes the three tiles of the row
+// already done, which vectorizes, then the tile before it in the same row
+static void ChamferPass(MapNode* TileMap, int x0, int y0, int x1, int y1, bool forward){
+    int width = TileMap->matrix_width;
+    int step = forward ? 1 : -1;
+    int inner_x0 = x0 > 0 ? x0 : 1; // Columns whose both neighbours are in the map
+    int inner_x1 = x1 < width - 1 ? x1 : width - 2;
+
+    for (int y = forward ? y0 : y1; forward ? y <= y1 : y >= y0; y += step) {
+        uint8_t* row = &TileMap->distance[TileIndex(TileMap, 0, y)];
+        int done_y = y - step;
+
+        if (done_y >= 0 && done_y < TileMap->matrix_height) {
+            const uint8_t* done = &TileMap->distance[TileIndex(TileMap, 0, done_y)];
+
+            for (int x = inner_x0; x <= inner_x1; x++) {
+                int diagonal = (done[x - 1] < done[x + 1] ? done[x - 1] : done[x + 1]) + DISTANCE_DIAGONAL;
+                int straight = done[x] + DISTANCE_STEP;
+                row[x] = Relax(row[x], diagonal < straight ? diagonal : straight);
+            }
+
+            if (x0 == 0) RelaxEdgeColumn(TileMap, row, 0, done_y);
+            if (x1 == width - 1 && width > 1) RelaxEdgeColumn(TileMap, row, width - 1, done_y);
+        } else {
+            for (int x = x0; x <= x1; x++) row[x] = Relax(row[x], DISTANCE_STEP); // Next to the edge of the map
+        }
+
+        int previous = FixedDistance(TileMap, forward ? x0 - 1 : x1 + 1, y);
+        for (int x = forward ? x0 : x1; forward ? x <= x1 : x >= x0; x += step) {
+            row[x] = Relax(row[x], previous + DISTANCE_STEP);
+            previous = row[x];
+        }
+    }
+}
+
+// Recomputes the distances of [x0, x1] x [y0, y1] (inside the map) from its blocking tiles and
+// the distances around it
+static void ChamferWindow(MapNode* TileMap, int x0, int y0, int x1, int y1){
+    size_t stride = BlockingStride(TileMap->matrix_width);
+
+    for (int y = y0; y <= y1; y++) {
+        const uint64_t* bits = &TileMap->blocking[(size_t)y * stride];
+        uint8_t* row = &TileMap->distance[TileIndex(TileMap, 0, y)];
+
+        for (int x = x0; x <= x1; x++) row[x] = ((bits[x >> 6] >> (x & 63)) & 1) ? 0 : DISTANCE_MAX;
+    }
+
+    ChamferPass(TileMap, x0, y0, x1, y1, true);
+    ChamferPass(TileMap, x0, y0, x1, y1, false);
+}
+
+// Flat maps only, called once the blocking bitset is final
+void BuildDistanceField(MapNode* TileMap){
+    if (TileMap->distance == NULL) return;
+
+    ChamferWindow(TileMap, 0, 0, TileMap->matrix_width - 1, TileMap->matrix_height - 1);
+}
+
+// Highest distance on the square ring radius tiles away from (x, y), inside the map
+static int RingMax(const MapNode* TileMap, int x, int y, int radius){
+    int highest = 0;
+
+    for (int i = -radius; i <= radius; i++) {
+        int sides[4][2] = { {x + i, y - radius}, {x + i, y + radius}, {x - radius, y + i}, {x + radius, y + i} };
+
+        for (int k = 0; k < 4; k++)
+            if (IsInsideMap(TileMap, sides[k][0], sides[k][1])) {
+                int distance = TileMap->distance[TileIndex(TileMap, sides[k][0], sides[k][1])];
+                if (distance > highest) highest = distance;
+            }
+    }
+
+    return highest;
+}
+
+// Only the tiles closer to (x, y) than to any other wall, before or after the change, can get a
+// new distance. The shortest path from one of them to (x, y) crosses every ring around it, so
+// the first ring whose tiles are all closer to another wall than the ring is to (x, y) bounds
+// them: the window inside it is recomputed, the ring itself stays as it is
+void RepairDistanceField(MapNode* TileMap, int x, int y){
+    if (TileMap->distance == NULL || !IsInsideMap(TileMap, x, y)) return;
+
+    int radius = 1;
+    while (RingMax(TileMap, x, y, radius) >= radius * DISTANCE_STEP) radius++;
+
+    int x0 = x - radius + 1, y0 = y - radius + 1, x1 = x + radius - 1, y1 = y + radius - 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= TileMap->matrix_width) x1 = TileMap->matrix_width - 1;
+    if (y1 >= TileMap->matrix_height) y1 = TileMap->matrix_height - 1;
+
+    ChamferWindow(TileMap, x0, y0, x1, y1);
+}
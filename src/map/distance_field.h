@@ -0,0 +1,51 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+//
+#include "maps.h"
+//
+// Distance from every tile to the closest blocking tile (or the map edge), built from the
+// blocking bitset with a two-pass 3-4 chamfer transform once per level. Stored in
+// MapNode.distance, one byte per tile: DISTANCE_STEP per tile sideways, DISTANCE_DIAGONAL per
+// tile diagonally, capped at DISTANCE_MAX. Blocking tiles are 0. Streamed maps have no field.
+//
+#define DISTANCE_STEP 3
+#define DISTANCE_DIAGONAL 4
+#define DISTANCE_MAX 255
+//
+//====== distance_field.c ==========================================================================//
+//
+void BuildDistanceField(MapNode* TileMap);
+void RepairDistanceField(MapNode* TileMap, int x, int y); // After the tile at (x, y) changed (SetTile)
+//
+//==================================================================================================//
+//
+// Distance from (x, y) to the closest wall, 0 out of the map and on streamed maps
+static inline int GetWallDistance(const MapNode* map, int x, int y) {
+    if (map->distance == NULL || !IsInsideMap(map, x, y)) return 0;
+    return map->distance[TileIndex(map, x, y)];
+}
+
+// Points away from the closest walls, (0, 0) far from any wall or on streamed maps
+static inline Vector2 GetWallGradient(const MapNode* map, int x, int y) {
+    return (Vector2){(float)(GetWallDistance(map, x + 1, y) - GetWallDistance(map, x - 1, y)),
+                     (float)(GetWallDistance(map, x, y + 1) - GetWallDistance(map, x, y - 1))};
+}
+//
+#endif // DISTANCE_FIELD_H
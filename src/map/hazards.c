@@ -0,0 +1,137 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "hazards.h"
+#include "../render/atlas.h"
+
+// Frame of every step of the cycle: down, rising, up for a while, going back down
+static const uint8_t spike_cycle[HAZARD_STEPS] = { 0, 0, 0, 0, 0, 0, 1, 2, 3, 3, 3, 3, 2, 1, 0, 0 };
+
+static inline uint8_t HazardOffset(uint32_t seed, int x, int y){
+    return (uint8_t)(RngHash2D(seed, RNG_STREAM_HAZARDS, x, y) % HAZARD_STEPS);
+}
+
+HazardList* InitHazardList(void){
+    HazardList* list = (HazardList*)calloc(1, sizeof(HazardList));
+
+    for (int i = 0; i < SPIKE_FRAMES; i++) list->frames[i] = GetSprite(TextFormat(SPIKE_FRAME_PATH, i));
+
+    return list;
+}
+
+void FreeHazardList(HazardList* list){
+    if (list == NULL) return;
+
+    free(list); // The hazards are in the arena of the level, the frames in the atlas
+}
+
+// The hazards live in the arena of the level, the old array is dropped with it
+static void GrowHazardList(Arena* arena, HazardList* list){
+    int capacity = list->capacity ? list->capacity * 2 : 64;
+    Hazard* hazards = (Hazard*)ArenaAlloc(arena, sizeof(Hazard) * (size_t)capacity);
+
+    if (list->count > 0) memcpy(hazards, list->hazards, sizeof(Hazard) * (size_t)list->count);
+    list->hazards = hazards;
+    list->capacity = capacity;
+}
+
+// Hazard tiles are rare, so the list is short whatever the size of the map
+void CollectHazards(MapNode* TileMap){
+    HazardList* list = TileMap->hazards;
+    if (list == NULL) return;
+
+    // Called once the arena was reset for the new level, the old array is gone
+    list->hazards = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    if (TileMap->chunks != NULL) return;
+
+    for (int y = 0; y < TileMap->matrix_height; y++) {
+        const uint8_t* row = &TileMap->tiles[TileIndex(TileMap, 0, y)];
+
+        for (int x = 0; x < TileMap->matrix_width; x++) {
+            if (!(TileProperties[row[x]] & TILE_FLAG_HAZARD)) continue;
+
+            if (list->count == list->capacity) GrowHazardList(TileMap->arena, list);
+            uint8_t offset = HazardOffset(TileMap->seed, x, y);
+            list->hazards[list->count++] = (Hazard){ x, y, offset, spike_cycle[(list->step + offset) % HAZARD_STEPS] };
+        }
+    }
+}
+
+// Drops the listed hazards of [x0, x1] x [y0, y1] that are gone and lists the new ones, for
+// tiles changed while playing
+void RepairHazards(MapNode* TileMap, int x0, int y0, int x1, int y1){
+    HazardList* list = TileMap->hazards;
+    if (list == NULL || TileMap->chunks != NULL) return;
+
+    for (int i = 0; i < list->count; ) {
+        Hazard* hazard = &list->hazards[i];
+        bool inside = hazard->x >= x0 && hazard->x <= x1 && hazard->y >= y0 && hazard->y <= y1;
+
+        if (inside && !HasTileFlag(TileMap, hazard->x, hazard->y, TILE_FLAG_HAZARD)) *hazard = list->hazards[--list->count];
+        else i++;
+    }
+
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++) {
+            if (!HasTileFlag(TileMap, x, y, TILE_FLAG_HAZARD)) continue;
+
+            bool listed = false;
+            for (int i = 0; i < list->count && !listed; i++) listed = list->hazards[i].x == x && list->hazards[i].y == y;
+            if (listed) continue;
+
+            if (list->count == list->capacity) GrowHazardList(TileMap->arena, list);
+            list->hazards[list->count++] = (Hazard){ x, y, HazardOffset(TileMap->seed, x, y), GetHazardFrame(TileMap, x, y) };
+        }
+}
+
+// The frames only change when the clock enters a new step, a few times per second
+void UpdateHazards(MapNode* TileMap, float deltaTime){
+    HazardList* list = TileMap->hazards;
+    if (list == NULL) return;
+
+    list->clock = fmodf(list->clock + deltaTime, HAZARD_STEPS * HAZARD_STEP_TIME);
+    int step = (int)(list->clock / HAZARD_STEP_TIME) % HAZARD_STEPS;
+    if (step == list->step) return;
+
+    list->step = step;
+    for (int i = 0; i < list->count; i++) {
+        Hazard* hazard = &list->hazards[i];
+        hazard->frame = spike_cycle[(step + hazard->offset) % HAZARD_STEPS];
+    }
+}
+
+uint8_t GetHazardFrame(const MapNode* TileMap, int x, int y){
+    int step = TileMap->hazards != NULL ? TileMap->hazards->step : 0;
+    return spike_cycle[(step + HazardOffset(TileMap->seed, x, y)) % HAZARD_STEPS];
+}
+
+// Only the tiles under the area are looked at, the list is not
+bool IsAreaOnArmedHazard(const MapNode* TileMap, Rectangle area){
+    if (TileMap->chunks != NULL) return false;
+
+    int x0 = (int)floorf(area.x / __TILE_SIZE), x1 = (int)ceilf((area.x + area.width) / __TILE_SIZE) - 1;
+    int y0 = (int)floorf(area.y / __TILE_SIZE), y1 = (int)ceilf((area.y + area.height) / __TILE_SIZE) - 1;
+
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            if (IsInsideMap(TileMap, x, y) && HasTileFlag(TileMap, x, y, TILE_FLAG_HAZARD)
+                && GetHazardFrame(TileMap, x, y) == SPIKE_ARMED_FRAME) return true;
+
+    return false;
+}
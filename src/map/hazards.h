@@ -0,0 +1,63 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HAZARDS_H
+#define HAZARDS_H
+//
+#include "maps.h"
+//
+// Animated hazards (floor spikes). Their tiles are found once per level and kept in a sparse
+// list, so a frame only costs the hazards of the level, not the map area. Every hazard follows
+// the same clock, HAZARD_STEPS steps per cycle, shifted by an offset rolled from its position,
+// so the state of any hazard tile is known without looking it up in the list.
+// Streamed maps have no hazards.
+//
+#define SPIKE_FRAME_PATH "res/frames/floor_spikes_anim_f%d.png"
+#define SPIKE_FRAMES 4
+#define SPIKE_ARMED_FRAME 3         // Spikes up, hurts the player (updatePlayerHealth)
+#define HAZARD_STEPS 16
+#define HAZARD_STEP_TIME 0.125f     // Seconds per step, a whole cycle takes 2 seconds
+//
+typedef struct {
+    int32_t x;
+    int32_t y;
+    uint8_t offset;         // Steps ahead of the shared clock
+    uint8_t frame;          // Current frame, 0 to SPIKE_FRAMES - 1
+} Hazard;
+
+struct HazardList {
+    Hazard* hazards;
+    int count;
+    int capacity;
+    float clock;            // Shared phase clock, in seconds
+    int step;               // Step of the clock the frames are up to date with
+    Sprite frames[SPIKE_FRAMES];
+};
+//
+//====== hazards.c =================================================================================//
+//
+HazardList* InitHazardList(void); // Looks the frames up in the atlas
+void FreeHazardList(HazardList* list);
+void CollectHazards(MapNode* TileMap); // Once the tiles of a new level are final
+void RepairHazards(MapNode* TileMap, int x0, int y0, int x1, int y1); // After tiles changed (see map_edit.h)
+void UpdateHazards(MapNode* TileMap, float deltaTime);
+uint8_t GetHazardFrame(const MapNode* TileMap, int x, int y); // For any hazard tile, listed or not
+bool IsAreaOnArmedHazard(const MapNode* TileMap, Rectangle area);
+//
+//==================================================================================================//
+//
+#endif // HAZARDS_H
@@ -0,0 +1,129 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level_cache.h"
+#include "maps.h"
+#include "automata.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static bool level_cache_enabled = true;
+
+void SetLevelCacheEnabled(bool enabled){
+    level_cache_enabled = enabled;
+}
+
+static void LevelCachePath(char* path, size_t size, uint32_t seed, int width, int height){
+    snprintf(path, size, "%s/level_%08x_%dx%d.bin", LEVEL_CACHE_DIR, seed, width, height);
+}
+
+static size_t LevelCacheSize(int width, int height, int num_enemies){
+    return sizeof(LevelCacheHeader) + MapPlanesSize(width, height) + (size_t)num_enemies * sizeof(EnemySpawn);
+}
+
+// FNV-1a, fed in pieces so the header and the payload do not need to be contiguous
+static uint64_t HashBytes(uint64_t hash, const uint8_t* data, size_t size){
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool LoadLevelCache(MapNode* TileMap, EnemySpawn* spawns){
+    if (!level_cache_enabled) return false;
+
+    char path[256];
+    LevelCachePath(path, sizeof(path), TileMap->seed, TileMap->matrix_width, TileMap->matrix_height);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    size_t expected = LevelCacheSize(TileMap->matrix_width, TileMap->matrix_height, TileMap->num_enemies);
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size != expected) {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(NULL, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) return false;
+
+    const LevelCacheHeader* header = (const LevelCacheHeader*)mapping;
+    const uint8_t* payload = (const uint8_t*)mapping + sizeof(LevelCacheHeader);
+    size_t plane_size = MapPlanesSize(TileMap->matrix_width, TileMap->matrix_height);
+    size_t payload_size = expected - sizeof(LevelCacheHeader);
+
+    bool valid = header->magic == LEVEL_CACHE_MAGIC
+              && header->version == LEVEL_CACHE_VERSION
+              && header->seed == TileMap->seed
+              && header->width == TileMap->matrix_width
+              && header->height == TileMap->matrix_height
+              && header->num_enemies == TileMap->num_enemies
+              && header->rules == PackCaveRules(GetCaveRules())
+              && header->generator == (uint32_t)GetMapGenerator()
+              && header->checksum == HashBytes(14695981039346656037ULL, payload, payload_size);
+
+    if (valid) {
+        memcpy(TileMap->tiles, payload, plane_size); // The tiles and the blocking bitset
+        memcpy(spawns, payload + plane_size, (size_t)TileMap->num_enemies * sizeof(EnemySpawn));
+    }
+
+    munmap(mapping, expected);
+    return valid;
+}
+
+// Writes to a temporary file first, so a crash halfway never leaves a truncated level behind
+void SaveLevelCache(const MapNode* TileMap, const EnemySpawn* spawns){
+    if (!level_cache_enabled) return;
+
+    if (mkdir(LEVEL_CACHE_DIR, 0755) != 0 && errno != EEXIST) return;
+
+    char path[256], temp_path[288];
+    LevelCachePath(path, sizeof(path), TileMap->seed, TileMap->matrix_width, TileMap->matrix_height);
+    static unsigned int writes = 0; // Levels can be saved from several threads at once
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.%u.tmp", path, (int)getpid(), __atomic_fetch_add(&writes, 1, __ATOMIC_RELAXED));
+
+    size_t plane_size = MapPlanesSize(TileMap->matrix_width, TileMap->matrix_height);
+    size_t spawns_size = (size_t)TileMap->num_enemies * sizeof(EnemySpawn);
+
+    uint64_t checksum = HashBytes(14695981039346656037ULL, TileMap->tiles, plane_size);
+    checksum = HashBytes(checksum, (const uint8_t*)spawns, spawns_size);
+
+    LevelCacheHeader header = {
+        .magic = LEVEL_CACHE_MAGIC,
+        .version = LEVEL_CACHE_VERSION,
+        .seed = TileMap->seed,
+        .width = TileMap->matrix_width,
+        .height = TileMap->matrix_height,
+        .num_enemies = TileMap->num_enemies,
+        .rules = PackCaveRules(GetCaveRules()),
+        .generator = (uint32_t)GetMapGenerator(),
+        .checksum = checksum,
+    };
+
+    FILE* file = fopen(temp_path, "wb");
+    if (file == NULL) return;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                && fwrite(TileMap->tiles, 1, plane_size, file) == plane_size
+                && fwrite(spawns, 1, spawns_size, file) == spawns_size;
+
+    if (fclose(file) != 0 || !written || rename(temp_path, path) != 0) remove(temp_path);
+}
@@ -0,0 +1,62 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LEVEL_CACHE_H
+#define LEVEL_CACHE_H
+//
+#include "../defs.h"
+#include "../structs.h"
+//
+// Generated levels are saved to LEVEL_CACHE_DIR and loaded back (with mmap) the next time
+// the same level is requested. The level seed already folds in the world seed and the map
+// level, so a file is keyed by (level seed, width, height), and the generator settings.
+//
+// File layout: LevelCacheHeader, the map buffer (tiles and blocking bitset, see MapPlanesSize),
+// num_enemies EnemySpawn records.
+// All values are stored in the byte order of the machine that wrote them.
+//
+#define LEVEL_CACHE_DIR "cache"
+#define LEVEL_CACHE_MAGIC 0x434C4444u // "DDLC"
+#define LEVEL_CACHE_VERSION 11u       // Bump whenever the generator output changes, with the golden maps of map_bench.c
+//
+typedef struct {
+    int32_t x;              // Spawn tile
+    int32_t y;
+} EnemySpawn;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seed;
+    int32_t width;
+    int32_t height;
+    int32_t num_enemies;
+    uint32_t rules;         // PackCaveRules of the rules the level was smoothed with
+    uint32_t generator;     // MapGeneratorId the level was carved with
+    uint64_t checksum;      // FNV-1a of everything after the header
+} LevelCacheHeader;
+//
+//====== level_cache.c =============================================================================//
+//
+// Fills the planes of TileMap and spawns (TileMap->num_enemies records) from the cache.
+// Returns false, leaving TileMap untouched, if there is no file or it is corrupt or stale
+bool LoadLevelCache(MapNode* TileMap, EnemySpawn* spawns);
+void SaveLevelCache(const MapNode* TileMap, const EnemySpawn* spawns);
+void SetLevelCacheEnabled(bool enabled); // When disabled, nothing is loaded or saved (benchmarks)
+//
+//==================================================================================================//
+//
+#endif // LEVEL_CACHE_H
@@ -0,0 +1,230 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "level_graph.h"
+#include "distance_field.h"
+#include "hazards.h"
+#include "../entity/enemy.h"
+
+// Most tiles are the floor or wall variant the generator rolls from the tile coordinates, those
+// are stored as one of these two symbols and rolled again when the level is restored. That
+// leaves long runs of the same symbol, stored as (symbol, run length) pairs. The edge pieces of
+// the walls are stored as plain walls too, the autotiler puts them back from the neighbours (so
+// tiles changed while playing need InvalidateArea around them)
+enum {
+    SYMBOL_FLOOR = 0xFE,    // Tile ids stay far below these
+    SYMBOL_WALL = 0xFF
+};
+
+static LevelNode* nodes = NULL;
+static int node_count = 0;
+static int node_capacity = 0;
+static int lru_head = LEVEL_NONE;
+static int lru_tail = LEVEL_NONE;
+static size_t snapshot_bytes = 0;
+
+void InitLevelGraph(MapNode* TileMap, uint16_t map_level){
+    FreeLevelGraph();
+
+    TileMap->node_id = AddLevel(LEVEL_NONE, LEVEL_LINK_UP, TileMap->seed, map_level);
+}
+
+static void DropSnapshot(int node_id){
+    LevelNode* node = &nodes[node_id];
+    if (!node->saved) return;
+
+    snapshot_bytes -= node->tiles_size + (size_t)node->num_enemies * sizeof(LevelEnemy);
+    free(node->tiles);
+    free(node->enemies);
+    node->tiles = NULL;
+    node->tiles_size = 0;
+    node->enemies = NULL;
+    node->num_enemies = 0;
+    node->saved = false;
+
+    if (node->lru_prev != LEVEL_NONE) nodes[node->lru_prev].lru_next = node->lru_next;
+    else lru_head = node->lru_next;
+
+    if (node->lru_next != LEVEL_NONE) nodes[node->lru_next].lru_prev = node->lru_prev;
+    else lru_tail = node->lru_prev;
+}
+
+void FreeLevelGraph(void){
+    for (int i = 0; i < node_count; i++) DropSnapshot(i);
+
+    free(nodes);
+    nodes = NULL;
+    node_count = 0;
+    node_capacity = 0;
+}
+
+int GetLevelLink(int node_id, LevelLink link){
+    if (node_id < 0 || node_id >= node_count) return LEVEL_NONE;
+    return nodes[node_id].links[link];
+}
+
+const LevelNode* GetLevelNode(int node_id){
+    if (node_id < 0 || node_id >= node_count) return NULL;
+    return &nodes[node_id];
+}
+
+int AddLevel(int parent, LevelLink link, uint32_t seed, uint16_t map_level){
+    if (node_count == node_capacity) {
+        node_capacity = node_capacity ? node_capacity * 2 : 16;
+        nodes = (LevelNode*)realloc(nodes, (size_t)node_capacity * sizeof(LevelNode));
+    }
+
+    int node_id = node_count++;
+    nodes[node_id] = (LevelNode){
+        .seed = seed,
+        .map_level = map_level,
+        .links = { LEVEL_NONE, LEVEL_NONE, LEVEL_NONE },
+        .lru_prev = LEVEL_NONE,
+        .lru_next = LEVEL_NONE,
+    };
+
+    if (parent != LEVEL_NONE) {
+        nodes[parent].links[link] = node_id;
+        nodes[node_id].links[LEVEL_LINK_UP] = parent;
+    }
+
+    return node_id;
+}
+
+static uint8_t TileSymbol(uint32_t seed, int x, int y, uint8_t tile){
+    bool floor = !(TileProperties[tile] & TILE_FLAG_BLOCKING);
+
+    if (tile != GetCaveTile(seed, x, y, floor) && !IsAutotiledTile(tile)) return tile;
+    return floor ? SYMBOL_FLOOR : SYMBOL_WALL;
+}
+
+// Run lengths are stored 7 bits per byte, the high bit set on every byte but the last
+static size_t PutRun(uint8_t* out, size_t used, uint8_t symbol, size_t run){
+    out[used++] = symbol;
+
+    for (; run > 0x7F; run >>= 7) out[used++] = (uint8_t)((run & 0x7F) | 0x80);
+    out[used++] = (uint8_t)run;
+
+    return used;
+}
+
+static uint8_t* CompressTiles(const MapNode* TileMap, size_t* size){
+    size_t count = (size_t)TileMap->matrix_width * (size_t)TileMap->matrix_height;
+    uint8_t* out = (uint8_t*)malloc(count * 2 + 16); // A run of one tile takes two bytes
+    size_t used = 0, run = 0;
+    uint8_t current = 0;
+
+    for (int y = 0; y < TileMap->matrix_height; y++)
+        for (int x = 0; x < TileMap->matrix_width; x++) {
+            uint8_t symbol = TileSymbol(TileMap->seed, x, y, TileMap->tiles[TileIndex(TileMap, x, y)]);
+
+            if (run > 0 && symbol != current) {
+                used = PutRun(out, used, current, run);
+                run = 0;
+            }
+
+            current = symbol;
+            run++;
+        }
+
+    if (run > 0) used = PutRun(out, used, current, run);
+
+    *size = used;
+    return (uint8_t*)realloc(out, used);
+}
+
+static void DecompressTiles(MapNode* TileMap, const uint8_t* data, size_t size){
+    size_t i = 0;
+    int x = 0, y = 0;
+
+    for (size_t read = 0; read < size; ) {
+        uint8_t symbol = data[read++];
+        size_t run = 0;
+
+        for (int shift = 0; ; shift += 7) {
+            uint8_t byte = data[read++];
+            run |= (size_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+
+        for (size_t end = i + run; i < end; i++) {
+            if (symbol == SYMBOL_FLOOR) TileMap->tiles[i] = GetCaveTile(TileMap->seed, x, y, true);
+            else if (symbol == SYMBOL_WALL) TileMap->tiles[i] = GetCaveTile(TileMap->seed, x, y, false);
+            else TileMap->tiles[i] = symbol;
+
+            if (++x == TileMap->matrix_width) { x = 0; y++; }
+        }
+    }
+}
+
+void SaveLevel(const MapNode* TileMap, Vector2 exit_position){
+    int node_id = TileMap->node_id;
+    if (node_id < 0 || node_id >= node_count) return;
+
+    DropSnapshot(node_id);
+
+    LevelNode* node = &nodes[node_id];
+    node->exit_position = exit_position;
+
+    if (TileMap->chunks == NULL) node->tiles = CompressTiles(TileMap, &node->tiles_size);
+
+    node->num_enemies = TileMap->num_enemies;
+    node->enemies = (LevelEnemy*)malloc(sizeof(LevelEnemy) * (size_t)TileMap->num_enemies);
+    for (int i = 0; i < TileMap->num_enemies; i++) {
+        const Entity* entity = &TileMap->enemies[i]->entity;
+        node->enemies[i] = (LevelEnemy){ entity->spawn_point, entity->position, entity->health, entity->isAlive };
+    }
+
+    node->saved = true;
+    snapshot_bytes += node->tiles_size + (size_t)node->num_enemies * sizeof(LevelEnemy);
+
+    node->lru_prev = LEVEL_NONE;
+    node->lru_next = lru_head;
+    if (lru_head != LEVEL_NONE) nodes[lru_head].lru_prev = node_id;
+    else lru_tail = node_id;
+    lru_head = node_id;
+
+    while (snapshot_bytes > LEVEL_GRAPH_MEMORY_BUDGET && lru_tail != node_id) DropSnapshot(lru_tail);
+}
+
+bool RestoreLevel(MapNode* TileMap, int node_id){
+    if (node_id < 0 || node_id >= node_count || !nodes[node_id].saved) return false;
+
+    const LevelNode* node = &nodes[node_id];
+    ResetArena(TileMap->arena); // Same as GenerateMap, the level left takes its allocations along
+    TileMap->node_id = node_id;
+    TileMap->seed = node->seed;
+
+    if (TileMap->chunks != NULL) {
+        ResetChunkManager(TileMap->chunks, node->seed);
+    } else {
+        DecompressTiles(TileMap, node->tiles, node->tiles_size);
+        GetTileInfo(TileMap);
+        AutotileWalls(TileMap);
+        BuildDistanceField(TileMap);
+    }
+
+    CollectHazards(TileMap);
+
+    TileMap->num_enemies = node->num_enemies;
+    for (int i = 0; i < node->num_enemies; i++) {
+        const LevelEnemy* enemy = &node->enemies[i];
+        RestoreEnemy(TileMap->enemies[i], enemy->spawn_point, enemy->position, enemy->health, enemy->isAlive);
+    }
+
+    return true;
+}
@@ -0,0 +1,82 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef LEVEL_GRAPH_H
+#define LEVEL_GRAPH_H
+//
+#include "maps.h"
+//
+// Every level the player visits is a node of the level graph, MapNode.node_id is its index.
+// Stairs and holes link a level to the ones below it and the ladder next to the spawn point
+// links it back to the level it was entered from, so links always go both ways.
+//
+// When the player leaves a level, its tiles and enemies are compressed into memory. Going back
+// to it restores it as it was left, without generating anything. The snapshots are evicted,
+// least recently used first, past LEVEL_GRAPH_MEMORY_BUDGET: those levels are generated again
+// from their seed, with new enemies. Streamed maps only keep the enemies, their chunks are
+// generated from the seed anyway.
+//
+#define LEVEL_GRAPH_MEMORY_BUDGET (32 * 1024 * 1024) // Compressed snapshots kept, in bytes
+#define LEVEL_NONE (-1)
+//
+typedef enum {
+    LEVEL_LINK_STAIR,       // Down the stairs
+    LEVEL_LINK_HOLE,        // Down a hole
+    LEVEL_LINK_UP,          // Up the ladder, to the level this one was entered from
+    LEVEL_LINK_COUNT
+} LevelLink;
+
+typedef struct {
+    Vector2 spawn_point;
+    Vector2 position;
+    float health;
+    bool isAlive;
+} LevelEnemy;
+
+typedef struct {
+    uint32_t seed;
+    uint16_t map_level;
+    int links[LEVEL_LINK_COUNT]; // Node ids, LEVEL_NONE until the link is taken
+    Vector2 exit_position;  // Where the player was when leaving the level, back there when coming up
+    bool saved;             // There is a snapshot of the level
+    uint8_t* tiles;         // Compressed tiles, NULL on streamed maps
+    size_t tiles_size;
+    LevelEnemy* enemies;
+    int num_enemies;
+    int lru_prev;           // Snapshots, most recently saved first
+    int lru_next;
+} LevelNode;
+//
+//====== level_graph.c =============================================================================//
+//
+// Starts a new graph with TileMap as its only node (id 0)
+void InitLevelGraph(MapNode* TileMap, uint16_t map_level);
+void FreeLevelGraph(void);
+// LEVEL_NONE for unknown nodes and links not taken yet
+int GetLevelLink(int node_id, LevelLink link);
+const LevelNode* GetLevelNode(int node_id);
+// Creates the node reached from parent through link, and links it back to parent
+int AddLevel(int parent, LevelLink link, uint32_t seed, uint16_t map_level);
+// Compresses the level of TileMap->node_id into memory
+void SaveLevel(const MapNode* TileMap, Vector2 exit_position);
+// Puts the level back in TileMap (tiles, blocking bitset, seed, node id and enemies). Returns
+// false, leaving TileMap untouched, if the level has no snapshot
+bool RestoreLevel(MapNode* TileMap, int node_id);
+//
+//==================================================================================================//
+//
+#endif // LEVEL_GRAPH_H
@@ -0,0 +1,99 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "map_edit.h"
+#include "distance_field.h"
+#include "hazards.h"
+#include "../render/tile_cache.h"
+
+static InvalidationTimings* invalidation_timings = NULL;
+
+void SetInvalidationTimings(InvalidationTimings* timings){
+    invalidation_timings = timings;
+}
+
+static double InvalidationClock(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+// Adds the time since *start to the stage and restarts the clock
+static void EndInvalidationStage(InvalidationStage stage, int x0, int y0, int x1, int y1, double* start){
+    if (invalidation_timings == NULL) return;
+
+    double now = InvalidationClock();
+    invalidation_timings->seconds[stage] += now - *start;
+    invalidation_timings->tiles[stage] += (unsigned long)(x1 - x0 + 1) * (unsigned long)(y1 - y0 + 1);
+    *start = now;
+}
+
+// Cracked walls turn into the floor the generator would have rolled there
+bool BreakTile(MapNode* TileMap, int x, int y){
+    if (!IsInsideMap(TileMap, x, y) || !HasTileFlag(TileMap, x, y, TILE_FLAG_BREAKABLE)) return false;
+
+    double start = InvalidationClock();
+    SetTile(TileMap, x, y, GetCaveTile(TileMap->seed, x, y, true));
+    EndInvalidationStage(INVALIDATION_STAGE_TILES, x, y, x, y, &start);
+
+    InvalidateArea(TileMap, x, y, x, y);
+    return true;
+}
+
+void InvalidateArea(MapNode* TileMap, int x0, int y0, int x1, int y1){
+
+    #ifdef DEBUG
+    double invalidation_start = InvalidationClock();
+    #endif /* ifndef DEBUG */
+
+    double start = InvalidationClock();
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= TileMap->matrix_width) x1 = TileMap->matrix_width - 1;
+    if (y1 >= TileMap->matrix_height) y1 = TileMap->matrix_height - 1;
+    if (x0 > x1 || y0 > y1) return;
+
+    // The pieces of the walls around the rectangle depend on the tiles inside it
+    int ring_x0 = x0 > 0 ? x0 - 1 : x0, ring_y0 = y0 > 0 ? y0 - 1 : y0;
+    int ring_x1 = x1 < TileMap->matrix_width - 1 ? x1 + 1 : x1, ring_y1 = y1 < TileMap->matrix_height - 1 ? y1 + 1 : y1;
+
+    AutotileArea(TileMap, ring_x0, ring_y0, ring_x1, ring_y1);
+    EndInvalidationStage(INVALIDATION_STAGE_AUTOTILE, ring_x0, ring_y0, ring_x1, ring_y1, &start);
+
+    InvalidateTileCache(TileMap->tile_cache, ring_x0, ring_y0, ring_x1, ring_y1); // Baked again when next drawn
+
+    if (TileMap->chunks == NULL) {
+        // The wall pieces do not change the blocking bits, only the rectangle can move a wall
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) RepairDistanceField(TileMap, x, y);
+        EndInvalidationStage(INVALIDATION_STAGE_DISTANCE, x0, y0, x1, y1, &start);
+
+        RepairHazards(TileMap, x0, y0, x1, y1);
+        EndInvalidationStage(INVALIDATION_STAGE_HAZARDS, x0, y0, x1, y1, &start);
+    } else {
+        for (int y = ring_y0; y <= ring_y1; y++)
+            for (int x = ring_x0; x <= ring_x1; x++) RecordChunkEdit(TileMap->chunks, x, y, GetTile(TileMap, x, y));
+        EndInvalidationStage(INVALIDATION_STAGE_CHUNKS, ring_x0, ring_y0, ring_x1, ring_y1, &start);
+    }
+
+    if (invalidation_timings != NULL) invalidation_timings->invalidations++;
+
+    #ifdef DEBUG
+    printf("Tiles (%d, %d) to (%d, %d) invalidated in %.1f us\n", x0, y0, x1, y1, (InvalidationClock() - invalidation_start) * 1e6);
+    #endif /* ifndef DEBUG */
+}
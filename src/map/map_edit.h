@@ -0,0 +1,53 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef MAP_EDIT_H
+#define MAP_EDIT_H
+//
+#include "maps.h"
+//
+// Tiles changed while playing. The change itself goes through SetTile (tile id and blocking
+// bit), then InvalidateArea repairs everything derived from the tiles, only around the
+// dirty rectangle: the wall pieces, the distance field, the hazard list and, on streamed maps,
+// the edit log that puts the change back when the chunk is generated again.
+// Flat levels keep their changes in the level graph snapshot, streamed levels lose them once
+// the player leaves the level.
+//
+typedef enum {
+    INVALIDATION_STAGE_TILES,       // SetTile, tile ids and blocking bits
+    INVALIDATION_STAGE_AUTOTILE,    // AutotileArea, one tile around the rectangle
+    INVALIDATION_STAGE_DISTANCE,    // RepairDistanceField, flat maps only
+    INVALIDATION_STAGE_HAZARDS,     // RepairHazards, flat maps only
+    INVALIDATION_STAGE_CHUNKS,      // RecordChunkEdit, streamed maps only
+    INVALIDATION_STAGE_COUNT
+} InvalidationStage;
+
+typedef struct {
+    double seconds[INVALIDATION_STAGE_COUNT]; // Added to, never reset
+    unsigned long tiles[INVALIDATION_STAGE_COUNT]; // Tiles each stage went over
+    unsigned long invalidations;
+} InvalidationTimings;
+//
+//====== map_edit.c ================================================================================//
+//
+bool BreakTile(MapNode* TileMap, int x, int y); // False when the tile is not breakable
+void InvalidateArea(MapNode* TileMap, int x0, int y0, int x1, int y1); // After SetTile on [x0, x1] x [y0, y1]
+void SetInvalidationTimings(InvalidationTimings* timings); // NULL stops the timing
+//
+//==================================================================================================//
+//
+#endif // MAP_EDIT_H
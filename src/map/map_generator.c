@@ -16,113 +16,490 @@
 
 #include "maps.h"
 #include "noise.h"
+#include "level_cache.h"
+#include "prefetch.h"
+#include "regions.h"
+#include "poisson.h"
+#include "bsp.h"
+#include "wfc.h"
+#include "automata.h"
+#include "../render/atlas.h"
+#include "autotile.h"
+#include "distance_field.h"
+#include "hazards.h"
 #include "tiles.h"
 #include "../entity/enemy.h"
+#include "../utils/threads.h"
+#include <strings.h>
+
+#define GENERATION_BAND_ROWS 16 // Rows given to a worker at a time
+
+// Thread local, so levels prefetched on other threads do not add to the timings of the caller
+static __thread GenerationTimings* generation_timings = NULL;
+
+void SetGenerationTimings(GenerationTimings* timings){
+    generation_timings = timings;
+}
+
+static double StageClock(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+// Adds the time since *start to the stage and restarts the clock
+static void EndStage(GenerationStage stage, double* start){
+    if (generation_timings == NULL) return;
+
+    double now = StageClock();
+    generation_timings->seconds[stage] += now - *start;
+    *start = now;
+}
 
 // function header in tiles.h
-Texture2D* InitTiles(void){
+Sprite* InitTiles(void){
 
-    Texture2D* textures = malloc(sizeof(Texture2D) * TILE_TYPE_COUNT);
+    Sprite* sprites = malloc(sizeof(Sprite) * TILE_TYPE_COUNT);
     
-    for (int i = 0; i < TILE_TYPE_COUNT; i++) textures[i] = LoadTexture(TilePaths[i]);
+    for (int i = 0; i < TILE_TYPE_COUNT; i++) sprites[i] = GetSprite(TilePaths[i]);
     
-    return textures;
+    return sprites;
+}
+
+void FreeTiles(Sprite* sprites){
+
+    free(sprites); // The atlas outlives the maps
 }
 
 void GenerateMap(MapNode* TileMap) {
 
-    TileMap->textures = InitTiles();
+    #ifdef DEBUG
+    double generation_start = GetTime();
+    #endif /* ifndef DEBUG */
+
+    // Everything the previous level kept in the arena goes at once
+    ResetArena(TileMap->arena);
+    EnemySpawn* spawns = (EnemySpawn*)ArenaAlloc(TileMap->arena, sizeof(EnemySpawn) * (size_t)GetEnemyCount(TileMap->matrix_width));
+
+    // A level prefetched while the previous one was played is swapped in, the others are
+    // loaded from the cache or generated here
+    bool prefetched = TakePrefetchedLevel(TileMap, spawns);
+    bool cached = !prefetched && GenerateLevelData(TileMap, spawns);
+    (void)cached; // Only reported by debug builds
+
+    PopulateMap(TileMap, spawns);
+    CollectHazards(TileMap);
+
+    #ifdef DEBUG
+    printf("Map %dx%d %s in %.2f ms on %d threads, checksum %016llx\n", TileMap->matrix_width, TileMap->matrix_height,
+           prefetched ? "prefetched" : cached ? "loaded from cache" : "generated", (GetTime() - generation_start) * 1000.0,
+           GetWorkerCount(), (unsigned long long)MapChecksum(TileMap));
+    printf("Level arena: %lu allocations, %zu KB high water, %zu KB in %lu blocks taken from the system\n",
+           TileMap->arena->peak_allocations, TileMap->arena->high_water / 1024, TileMap->arena->reserved_bytes / 1024,
+           TileMap->arena->system_allocations);
+    #endif /* ifndef DEBUG */
+
+    return;
+}
+
+// Never the ladder, it is the only way back to the level above
+static void DigCorridorTile(MapNode* TileMap, int x, int y){
+    if (IsTileBlocking(TileMap, x, y) && !HasTileFlag(TileMap, x, y, TILE_FLAG_LADDER)) SetTile(TileMap, x, y, FLOOR_1);
+}
+
+// The caves can leave the spawn point in a pocket cut off from the rest of the map, with no
+// room for the stairs. Digs a corridor from the spawn point to the closest tile of the largest
+// region and labels the regions again. Returns the region of the spawn point
+static int ConnectSpawnRegion(MapNode* TileMap, MapRegions* regions){
+    int spawn_x = TileMap->matrix_width / 2;
+    int spawn_y = TileMap->matrix_height / 2;
+    int spawn_region = GetRegion(regions, spawn_x, spawn_y);
+    if (spawn_region == REGION_NONE) return REGION_NONE;
+
+    int largest = 0;
+    for (int region = 1; region < regions->region_count; region++)
+        if (GetRegionSize(regions, region) > GetRegionSize(regions, largest)) largest = region;
+
+    if (largest == spawn_region) return spawn_region;
 
-    InitWalls(TileMap);
+    int target_x = spawn_x, target_y = spawn_y, best = INT32_MAX;
+    for (uint32_t i = regions->region_start[largest]; i < regions->region_start[largest + 1]; i++) {
+        int x = (int)(regions->tiles[i] % (uint32_t)TileMap->matrix_width);
+        int y = (int)(regions->tiles[i] / (uint32_t)TileMap->matrix_width);
+        int distance = abs(x - spawn_x) + abs(y - spawn_y);
+
+        if (distance < best) { best = distance; target_x = x; target_y = y; }
+    }
+
+    // Both ends are inside the borders, so the corridor is too. The ladder is right above the
+    // spawn point, a corridor going straight up goes up the next column and comes back at the end
+    int column = (target_x == spawn_x && target_y < spawn_y) ? spawn_x + 1 : target_x;
+    int x = spawn_x, y = spawn_y;
+    while (x != column) { x += (column > x) ? 1 : -1; DigCorridorTile(TileMap, x, y); }
+    while (y != target_y) { y += (target_y > y) ? 1 : -1; DigCorridorTile(TileMap, x, y); }
+    while (x != target_x) { x += (target_x > x) ? 1 : -1; DigCorridorTile(TileMap, x, y); }
+
+    FreeRegions(regions);
+    LabelRegions(TileMap, regions);
+    return GetRegion(regions, spawn_x, spawn_y);
+}
+
+// Enemy spawns, any walkable tile
+static bool IsSpawnTile(const void* context, int x, int y) {
+    return !IsTileBlocking((const MapNode*)context, x, y);
+}
+
+// Everything but the textures and the enemies: tiles, blocking bitset and the enemy spawns (num_enemies
+// records). It does not touch the GPU, so it can run on any thread. Returns true when the
+// level came from the cache
+bool GenerateLevelData(MapNode* TileMap, EnemySpawn* spawns) {
+    double stage_start = StageClock();
+    TileMap->num_enemies = GetEnemyCount(TileMap->matrix_width);
+
+    // Streamed maps are never cached, their chunks are generated on demand
+    bool cached = TileMap->chunks == NULL && LoadLevelCache(TileMap, spawns);
+    EndStage(GENERATION_STAGE_CACHE, &stage_start);
+
+    if (cached) {
+        BuildDistanceField(TileMap); // Not in the cache, rebuilt from the blocking bitset
+        EndStage(GENERATION_STAGE_DISTANCE, &stage_start);
+        return true;
+    }
+
+    Rng rng;
+    RngSeed(&rng, TileMap->seed, RNG_STREAM_ENEMIES);
+
+    if (TileMap->chunks != NULL) {
+        ResetChunkManager(TileMap->chunks, TileMap->seed);
+
+        // No regions on streamed maps, enemies are dropped around the spawn and walk out of
+        // the walls they land in
+        int window = MAP_STREAMING_THRESHOLD;
+        for (int i = 0; i < TileMap->num_enemies ; i++) {
+            spawns[i].x = (int32_t)(TileMap->matrix_width / 2 - window / 2 + (int)RngRange(&rng, (uint32_t)window));
+            spawns[i].y = (int32_t)(TileMap->matrix_height / 2 - window / 2 + (int)RngRange(&rng, (uint32_t)window));
+        }
+
+        return false;
+    }
+
+    GetGeneratorBackend(GetMapGenerator())->carve(TileMap); // Ends the walls and cleanup stages itself
+    stage_start = StageClock();
     ClearSpawnPoint(TileMap);
-    InitObjects(TileMap);
+    EndStage(GENERATION_STAGE_SPAWN, &stage_start);
     InitBorders(TileMap);
+    EndStage(GENERATION_STAGE_BORDERS, &stage_start);
+    GetTileInfo(TileMap);
+    EndStage(GENERATION_STAGE_TILE_INFO, &stage_start);
+
+    // Objects and enemies only go where the player can get from the spawn point
+    MapRegions regions;
+    LabelRegions(TileMap, &regions);
+    int spawn_region = ConnectSpawnRegion(TileMap, &regions);
+    EndStage(GENERATION_STAGE_REGIONS, &stage_start);
 
-    TileMap->num_enemies =  TileMap->matrix_width / 20;
-    TileMap->enemies = malloc(sizeof(Enemy*) * (size_t)TileMap->num_enemies );
+    // After the corridor and before the objects, so stairs and holes never end a wall
+    AutotileWalls(TileMap);
+    EndStage(GENERATION_STAGE_AUTOTILE, &stage_start);
 
-    int rand_x, rand_y;
+    InitObjects(TileMap, &regions, spawn_region);
+    InitHazards(TileMap, &regions, spawn_region);
+    EndStage(GENERATION_STAGE_OBJECTS, &stage_start);
+
+    BuildDistanceField(TileMap);
+    EndStage(GENERATION_STAGE_DISTANCE, &stage_start);
+
+    // Only maps too small to hold the spawn point have no spawn region
+    if (spawn_region == REGION_NONE) TileMap->num_enemies = 0;
+
+    uint32_t* samples = NULL;
+    uint32_t count = 0;
+    if (spawn_region != REGION_NONE) {
+        float radius = GetPoissonRadius(GetRegionSize(&regions, spawn_region), TileMap->num_enemies, ENEMY_SPACING);
+        count = SamplePoissonDisk(&regions, spawn_region, radius, IsSpawnTile, TileMap, &rng, TileMap->arena, &samples);
+    }
 
     for (int i = 0; i < TileMap->num_enemies ; i++) {
-        rand_x = rand() % TileMap->matrix_width;
-        rand_y = rand() % TileMap->matrix_height;
+        // Past the samples, on regions too small to space them all out, any tile of the region
+        uint32_t tile = (uint32_t)i < count ? samples[i] : SampleRegion(&regions, spawn_region, &rng);
+        int x = (int)(tile % (uint32_t)TileMap->matrix_width);
+        int y = (int)(tile / (uint32_t)TileMap->matrix_width);
+
+        // Regions are labeled before the objects, one of them may have taken the tile
+        if (IsTileBlocking(TileMap, x, y)) {
+            for (int k = 0; k < 4; k++) {
+                int next_x = x + (k == 0) - (k == 1), next_y = y + (k == 2) - (k == 3);
+                if (!IsTileBlocking(TileMap, next_x, next_y)) { x = next_x; y = next_y; break; }
+            }
+        }
 
-        TileMap->enemies[i] = (Enemy*)InitEnemy(rand_x, rand_y);
+        spawns[i].x = (int32_t)x;
+        spawns[i].y = (int32_t)y;
     }
-    
-    GetTileInfo(TileMap);
 
-    return;
+    FreeRegions(&regions); // The samples too
+    EndStage(GENERATION_STAGE_ENEMIES, &stage_start);
+
+    SaveLevelCache(TileMap, spawns);
+    EndStage(GENERATION_STAGE_CACHE, &stage_start);
+
+    return false;
 }
 
-// Get the tile info for each tile based on the generated matrix map
-void GetTileInfo(MapNode *TileMap){
-    for (int i = 0; i < TileMap->matrix_height; i++) {
-        for (int j = 0; j < TileMap->matrix_width; j++) {
-            
-            if (TileMap->matrix[i][j] == FLOOR_STAIRS)
-                TileMap->tile_info[i][j].isStair = true;
-
-            else
-                TileMap->tile_info[i][j].isStair = false;
-
-            if (TileMap->matrix[i][j] == HOLE) TileMap->tile_info[i][j].isHole = true;
-            else 
-                TileMap->tile_info[i][j].isHole = false;
-            
-
-            // Everything that is not a floor, must be blocking, check tiles.h for the values
-            if (TileMap->matrix[i][j] <= FLOOR_8)
-                TileMap->tile_info[i][j].blocking = false; 
-            else
-                TileMap->tile_info[i][j].blocking = true; 
+// Loads what needs the GPU (or the audio device), must run on the main thread. Textures and
+// enemies of the previous level are reused, so going down a level loads nothing new
+void PopulateMap(MapNode* TileMap, const EnemySpawn* spawns) {
+    if (TileMap->sprites == NULL) TileMap->sprites = InitTiles();
+    if (TileMap->hazards == NULL) TileMap->hazards = InitHazardList();
+
+    if (TileMap->enemies == NULL) {
+        // Sized for the most enemies a level of this size can have, num_enemies is lower on
+        // levels with no spawn region and the array is reused by the next levels
+        int capacity = GetEnemyCount(TileMap->matrix_width);
+        TileMap->enemies = malloc(sizeof(Enemy*) * (size_t)capacity);
+
+        for (int i = 0; i < capacity; i++) {
+            int x = i < TileMap->num_enemies ? spawns[i].x : TileMap->matrix_width / 2;
+            int y = i < TileMap->num_enemies ? spawns[i].y : TileMap->matrix_height / 2;
+            TileMap->enemies[i] = (Enemy*)InitEnemy(x * __TILE_SIZE, y * __TILE_SIZE);
         }
+    } else {
+        for (int i = 0; i < TileMap->num_enemies ; i++)
+            RespawnEnemy(TileMap->enemies[i], spawns[i].x * __TILE_SIZE, spawns[i].y * __TILE_SIZE);
     }
 }
 
-void InitWalls(MapNode* TileMap) { // Fill the map with Perlin noise
-  
-    for (int i = 0; i < TileMap->matrix_height; i++) {
-        for (int j = 0; j < TileMap->matrix_width; j++) {
+static void TileInfoBand(void* context, int start_row, int end_row){
+    MapNode* TileMap = (MapNode*)context;
+    int width = TileMap->matrix_width;
+    size_t stride = BlockingStride(width);
 
-            int y_seed = rand() % 23;
-            int x_seed = rand() % 43;
+    for (int i = start_row; i < end_row; i++) {
+        const uint8_t* row = &TileMap->tiles[TileIndex(TileMap, 0, i)];
+        uint64_t* bits = &TileMap->blocking[(size_t)i * stride];
 
-            if (perlin2d((double)i / y_seed, (double)j / x_seed) < 0.5) {
+        for (size_t word = 0; word < stride; word++) {
+            int first = (int)word * 64;
+            int last = first + 64 < width ? first + 64 : width;
+            uint64_t packed = 0;
 
-                int floor = rand() % 30;
-                if(floor > 8 || floor == 0) floor = FLOOR_1;
-                
-                TileMap->matrix[i][j] = floor;
-                
-            } else {
+            for (int j = first; j < last; j++)
+                packed |= (uint64_t)(TileProperties[row[j]] & TILE_FLAG_BLOCKING) << (j - first);
 
-                int rand_wall = rand() % 10000;
-                if (rand_wall < 9000) TileMap->matrix[i][j] = WALL_MID;
-                else if (rand_wall < 9500) TileMap->matrix[i][j] = WALL_HOLE_1;
-                else if (rand_wall < 9900) TileMap->matrix[i][j] = WALL_HOLE_2;
-                else if (rand_wall <= 10000) TileMap->matrix[i][j] = WALL_BANNER;
-            
-            }
+            bits[word] = packed; // Padding bits after the last column stay clear
         }
     }
 
-    // Making sure that the path is clear
-    for (int i = 0; i < TileMap->matrix_height; i++) {
+    // 0 turns off the IsAreaBlocking shortcut until BuildDistanceField runs
+    memset(&TileMap->distance[TileIndex(TileMap, 0, start_row)], 0, (size_t)width * (size_t)(end_row - start_row));
+}
+
+// Builds the blocking bitset from the generated tiles, in row bands. The distance field is
+// cleared, it must be built again once the blocking tiles are final
+void GetTileInfo(MapNode *TileMap){
+    ParallelFor(TileMap->matrix_height, GENERATION_BAND_ROWS, TileInfoBand, TileMap);
+}
+
+// The noise pass writes to a scratch plane and the cleanup pass writes the final tiles from it.
+// Reading from one plane and writing to the other makes the cleanup independent of the order
+// the tiles are visited in.
+typedef struct {
+    MapNode* TileMap;
+    uint8_t* walls;
+    NoiseContext noise;
+} WallsJob;
+
+static void WallsBand(void* context, int start_row, int end_row){
+    WallsJob* job = (WallsJob*)context;
+    MapNode* TileMap = job->TileMap;
+    int width = TileMap->matrix_width;
+    float* noise = (float*)ArenaAlloc(TileMap->arena, (size_t)width * (size_t)(end_row - start_row) * sizeof(float));
+
+    fbm2d_block(&job->noise, 0, start_row, width, end_row - start_row, noise);
+
+    for (int i = start_row; i < end_row; i++) {
+        uint8_t* row = &job->walls[TileIndex(TileMap, 0, i)];
+        const float* noise_row = &noise[(size_t)(i - start_row) * (size_t)width];
+
+        for (int j = 0; j < width; j++)
+            row[j] = ClassifyCaveTile(TileMap->seed, j, i, noise_row[j]);
+    }
+}
+
+static void CleanupBand(void* context, int start_row, int end_row){
+    WallsJob* job = (WallsJob*)context;
+    MapNode* TileMap = job->TileMap;
+
+    for (int i = start_row; i < end_row; i++) {
+        size_t row = TileIndex(TileMap, 0, i);
+
         for (int j = 0; j < TileMap->matrix_width; j++) {
-            bool Issurrounded = IsSurroundedByFloor(TileMap, i, j);
-            if (Issurrounded) {
-                TileMap->matrix[i][j] = FLOOR_1;
-            }
+            const uint8_t* wall = &job->walls[row + (size_t)j];
+            bool Issurrounded = IsSurroundedByFloor(wall, TileMap->matrix_width, j, i, TileMap->matrix_width, TileMap->matrix_height);
+            TileMap->tiles[row + (size_t)j] = Issurrounded ? FLOOR_1 : *wall;
         }
     }
 }
 
-bool IsSurroundedByFloor(MapNode *TileMap, int i, int j) {
-    bool isTopFloor = i - 1 >= 0 && TileMap->matrix[i - 1][j] == FLOOR_1;
-    bool isBottomFloor = i + 1 < TileMap->matrix_height && TileMap->matrix[i + 1][j] == FLOOR_1;
-    bool isLeftFloor = j - 1 >= 0 && TileMap->matrix[i][j - 1] == FLOOR_1;
-    bool isRightFloor = j + 1 < TileMap->matrix_width && TileMap->matrix[i][j + 1] == FLOOR_1;
+// Smoothed walls: the noise is thresholded into a bit plane, the automaton runs on it and the
+// tiles are rolled from the result. Every step reads one plane and writes the other
+typedef struct {
+    MapNode* TileMap;
+    NoiseContext noise;
+    CaveRules rules;
+    uint64_t* src;
+    uint64_t* dst;
+    size_t stride;          // Words per row
+} CaveJob;
+
+static void CaveNoiseBand(void* context, int start_row, int end_row){
+    CaveJob* job = (CaveJob*)context;
+    int width = job->TileMap->matrix_width;
+    float* noise = (float*)ArenaAlloc(job->TileMap->arena, (size_t)width * (size_t)(end_row - start_row) * sizeof(float));
+
+    fbm2d_block(&job->noise, 0, start_row, width, end_row - start_row, noise);
+
+    for (int i = start_row; i < end_row; i++) {
+        uint64_t* row = &job->src[(size_t)i * job->stride];
+        const float* noise_row = &noise[(size_t)(i - start_row) * (size_t)width];
+
+        memset(row, 0, job->stride * sizeof(uint64_t));
+        for (int j = 0; j < width; j++)
+            if (noise_row[j] >= CAVE_FLOOR_THRESHOLD) row[j >> 6] |= 1ULL << (j & 63);
+    }
+}
+
+static void CaveStepBand(void* context, int start_row, int end_row){
+    CaveJob* job = (CaveJob*)context;
+    StepCaveAutomaton(job->src, job->dst, job->stride, job->TileMap->matrix_width, job->TileMap->matrix_height,
+                      start_row, end_row, job->rules);
+}
+
+static void CaveTilesBand(void* context, int start_row, int end_row){
+    CaveJob* job = (CaveJob*)context;
+    MapNode* TileMap = job->TileMap;
+
+    for (int i = start_row; i < end_row; i++) {
+        const uint64_t* bits = &job->src[(size_t)i * job->stride];
+        uint8_t* row = &TileMap->tiles[TileIndex(TileMap, 0, i)];
+
+        for (int j = 0; j < TileMap->matrix_width; j++)
+            row[j] = GetCaveTile(TileMap->seed, j, i, !((bits[j >> 6] >> (j & 63)) & 1));
+    }
+}
+
+static void SmoothWalls(MapNode* TileMap, CaveRules rules){
+    CaveJob job = { .TileMap = TileMap, .rules = rules };
+    job.stride = (size_t)BlockingStride(TileMap->matrix_width);
+    size_t words = job.stride * (size_t)TileMap->matrix_height;
+    ArenaMark scratch = GetArenaMark(TileMap->arena); // The planes and the noise of the bands
+    job.src = (uint64_t*)ArenaAlloc(TileMap->arena, words * sizeof(uint64_t));
+    job.dst = (uint64_t*)ArenaAlloc(TileMap->arena, words * sizeof(uint64_t));
+    InitNoise(&job.noise, TileMap->seed);
+
+    double stage_start = StageClock();
+    ParallelFor(TileMap->matrix_height, GENERATION_BAND_ROWS, CaveNoiseBand, &job);
+    EndStage(GENERATION_STAGE_WALLS, &stage_start);
+
+    for (int step = 0; step < rules.iterations; step++) {
+        ParallelFor(TileMap->matrix_height, GENERATION_BAND_ROWS, CaveStepBand, &job);
+        uint64_t* swap = job.src;
+        job.src = job.dst;
+        job.dst = swap;
+    }
+
+    ParallelFor(TileMap->matrix_height, GENERATION_BAND_ROWS, CaveTilesBand, &job);
+    EndStage(GENERATION_STAGE_CLEANUP, &stage_start);
+
+    RewindArena(TileMap->arena, scratch);
+}
+
+void InitWalls(MapNode* TileMap) { // Fill the map with Perlin noise
+    CaveRules rules = GetCaveRules();
+    if (rules.iterations > 0) {
+        SmoothWalls(TileMap, rules);
+        return;
+    }
+
+    WallsJob job = { .TileMap = TileMap };
+    ArenaMark scratch = GetArenaMark(TileMap->arena); // The walls and the noise of the bands
+    job.walls = (uint8_t*)ArenaAlloc(TileMap->arena, (size_t)TileMap->matrix_width * (size_t)TileMap->matrix_height);
+    InitNoise(&job.noise, TileMap->seed);
+
+    double stage_start = StageClock();
+    ParallelFor(TileMap->matrix_height, GENERATION_BAND_ROWS, WallsBand, &job);
+    EndStage(GENERATION_STAGE_WALLS, &stage_start);
+
+    // Making sure that the path is clear
+    ParallelFor(TileMap->matrix_height, GENERATION_BAND_ROWS, CleanupBand, &job);
+    EndStage(GENERATION_STAGE_CLEANUP, &stage_start);
+
+    RewindArena(TileMap->arena, scratch);
+}
+
+static void RoomsBand(void* context, int start_row, int end_row){
+    MapNode* TileMap = (MapNode*)context;
+    CarveBspRooms(TileMap->seed, TileMap->matrix_width, TileMap->matrix_height, 0, start_row, TileMap->matrix_width,
+                  end_row - start_row, &TileMap->tiles[TileIndex(TileMap, 0, start_row)], TileMap->matrix_width);
+}
+
+// Rooms and corridors, already connected, there is no cleanup. Bands are whole squares of the
+// BSP, so few squares are walked twice
+void InitRooms(MapNode* TileMap) {
+    double stage_start = StageClock();
+    ParallelFor(TileMap->matrix_height, BSP_SECTOR_SIZE, RoomsBand, TileMap);
+    EndStage(GENERATION_STAGE_WALLS, &stage_start);
+}
+
+// Pieces of the wfc generator. A wall right above a floor shows its front, only fronts get holes
+// and banners, never two side by side, and walls are at least two tiles tall
+enum { PIECE_FLOOR, PIECE_WALL, PIECE_FRONT, PIECE_HOLE_1, PIECE_HOLE_2, PIECE_BANNER, PIECE_COUNT };
+#define PIECES_ANY ((1u << PIECE_COUNT) - 1)
+#define PIECES_DECORATED (1u << PIECE_HOLE_1 | 1u << PIECE_HOLE_2 | 1u << PIECE_BANNER)
+#define PIECES_FRONT (1u << PIECE_FRONT | PIECES_DECORATED)
+#define PIECES_PLAIN (PIECES_ANY & ~PIECES_DECORATED)
+
+static const WfcPiece wfc_pieces[PIECE_COUNT] = {
+    //                                              Above                                  Right          Below                                  Left
+    [PIECE_FLOOR]  = { FLOOR_1,     true,  1.0f,  { 1u << PIECE_FLOOR | PIECES_FRONT,      PIECES_ANY,    1u << PIECE_FLOOR | 1u << PIECE_WALL,  PIECES_ANY } },
+    [PIECE_WALL]   = { WALL_MID,    false, 1.0f,  { 1u << PIECE_FLOOR | 1u << PIECE_WALL,  PIECES_ANY,    1u << PIECE_WALL | PIECES_FRONT,       PIECES_ANY } },
+    [PIECE_FRONT]  = { WALL_MID,    false, 1.0f,  { 1u << PIECE_WALL,                      PIECES_ANY,    1u << PIECE_FLOOR,                     PIECES_ANY } },
+    [PIECE_HOLE_1] = { WALL_HOLE_1, false, 0.12f, { 1u << PIECE_WALL,                      PIECES_PLAIN,  1u << PIECE_FLOOR,                     PIECES_PLAIN } },
+    [PIECE_HOLE_2] = { WALL_HOLE_2, false, 0.10f, { 1u << PIECE_WALL,                      PIECES_PLAIN,  1u << PIECE_FLOOR,                     PIECES_PLAIN } },
+    [PIECE_BANNER] = { WALL_BANNER, false, 0.04f, { 1u << PIECE_WALL,                      PIECES_PLAIN,  1u << PIECE_FLOOR,                     PIECES_PLAIN } },
+};
+
+static const WfcTileSet wfc_tiles = { wfc_pieces, PIECE_COUNT, PIECE_FLOOR, PIECE_WALL, PIECE_FRONT };
+
+typedef struct {
+    MapNode* TileMap;
+    NoiseContext noise;
+} WfcJob;
+
+static void WfcBand(void* context, int start_row, int end_row){
+    WfcJob* job = (WfcJob*)context;
+    MapNode* TileMap = job->TileMap;
+    CarveWfcTiles(&wfc_tiles, TileMap->seed, &job->noise, TileMap->matrix_width, TileMap->matrix_height, 0, start_row,
+                  TileMap->matrix_width, end_row - start_row, &TileMap->tiles[TileIndex(TileMap, 0, start_row)], TileMap->matrix_width);
+}
+
+// Tiles collapsed from the rules above, they already follow them, there is no cleanup. Bands are
+// whole rows of squares, so every square is solved once
+void InitWfc(MapNode* TileMap) {
+    WfcJob job = { .TileMap = TileMap };
+    InitNoise(&job.noise, TileMap->seed);
+
+    double stage_start = StageClock();
+    ParallelFor(TileMap->matrix_height, WFC_BLOCK_SIZE, WfcBand, &job);
+    EndStage(GENERATION_STAGE_WALLS, &stage_start);
+}
+
+// wall points to the tile at (x, y) in a plane where rows are stride tiles apart
+bool IsSurroundedByFloor(const uint8_t* wall, int stride, int x, int y, int width, int height) {
+    bool isTopFloor = y - 1 >= 0 && wall[-stride] == FLOOR_1;
+    bool isBottomFloor = y + 1 < height && wall[stride] == FLOOR_1;
+    bool isLeftFloor = x - 1 >= 0 && wall[-1] == FLOOR_1;
+    bool isRightFloor = x + 1 < width && wall[1] == FLOOR_1;
 
     return (isTopFloor && isBottomFloor) || (isLeftFloor && isRightFloor);
 }
@@ -135,36 +512,375 @@ void ClearSpawnPoint(MapNode* TileMap){
 
     for (int i = spawn_y -1; i <= spawn_y + 1; i++) {
         for (int j = spawn_x - 1; j <= spawn_x + 1; j++){
-            TileMap->matrix[i][j] = FLOOR_1;
+            SetTile(TileMap, j, i, FLOOR_1);
 
         }
     }
+
+    // Right above the player, leads back to the level above (see level_graph.h)
+    SetTile(TileMap, spawn_x, spawn_y - 1, FLOOR_LADDER);
+}
+
+// A floor tile with floors all around it, away from the player on arrival. Blocking it can not
+// cut its region in two, the tiles around it stay connected through each other. Objects are
+// OBJECT_SPACING apart, so placing one never closes the tiles around another
+static bool IsObjectTile(const void* context, int x, int y) {
+    const MapNode* TileMap = (const MapNode*)context;
+    if (abs(x - TileMap->matrix_width / 2) <= 2 && abs(y - TileMap->matrix_height / 2) <= 2) return false;
+
+    return !IsAreaBlocking(TileMap, (Rectangle){(float)((x - 1) * __TILE_SIZE), (float)((y - 1) * __TILE_SIZE),
+                                                3 * __TILE_SIZE, 3 * __TILE_SIZE});
+}
+
+static bool IsHazardTile(const void* context, int x, int y) {
+    const MapNode* TileMap = (const MapNode*)context;
+    if (abs(x - TileMap->matrix_width / 2) <= 3 && abs(y - TileMap->matrix_height / 2) <= 3) return false;
+
+    return GetTile(TileMap, x, y) == FLOOR_1; // Not on the objects
+}
+
+// Places the holes and the stairs on open tiles of the region, so all of them can be reached
+// from it. Needs the blocking bitset (GetTileInfo), SetTile keeps it up to date
+void InitObjects(MapNode* TileMap, const MapRegions* regions, int region) {
+
+    int num_objects = TileMap->matrix_width / 10 * 2;
+
+    if (region == REGION_NONE) return;
+
+    Rng rng;
+    RngSeed(&rng, TileMap->seed, RNG_STREAM_OBJECTS);
+
+    uint32_t* samples;
+    ArenaMark scratch = GetArenaMark(TileMap->arena);
+    float radius = GetPoissonRadius(GetRegionSize(regions, region), num_objects, OBJECT_SPACING);
+    uint32_t count = SamplePoissonDisk(regions, region, radius, IsObjectTile, TileMap, &rng, TileMap->arena, &samples);
+
+    // Bounded, small regions may not have room for all of them
+    for (uint32_t i = 0; i < count && i < (uint32_t)num_objects; i++) {
+        int x = (int)(samples[i] % (uint32_t)TileMap->matrix_width);
+        int y = (int)(samples[i] / (uint32_t)TileMap->matrix_width);
+        SetTile(TileMap, x, y, i % 2 == 0 ? HOLE : FLOOR_STAIRS);
+    }
+
+    RewindArena(TileMap->arena, scratch);
 }
 
-void InitObjects(MapNode* TileMap) {
+// Floor spikes on floor tiles of the region, away from the spawn point. They do not block, so
+// the region stays connected whatever tiles they land on
+void InitHazards(MapNode* TileMap, const MapRegions* regions, int region) {
+
+    int num_hazards = TileMap->matrix_width / 10;
 
-    int num_objects = TileMap->matrix_width / 10;
+    if (region == REGION_NONE) return;
 
-    for (int i = 0; i < num_objects; i++) {
+    Rng rng;
+    RngSeed(&rng, TileMap->seed, RNG_STREAM_HAZARDS);
 
-        TileMap->matrix[rand() % TileMap->matrix_width][rand() % TileMap->matrix_height] = HOLE;
+    uint32_t* samples;
+    ArenaMark scratch = GetArenaMark(TileMap->arena);
+    float radius = GetPoissonRadius(GetRegionSize(regions, region), num_hazards, HAZARD_SPACING);
+    uint32_t count = SamplePoissonDisk(regions, region, radius, IsHazardTile, TileMap, &rng, TileMap->arena, &samples);
 
-        int stair_x = rand() % TileMap->matrix_width;
-        int stair_y = rand() % TileMap->matrix_height;
-        TileMap->matrix[stair_y][stair_x] = FLOOR_STAIRS;
+    for (uint32_t i = 0; i < count && i < (uint32_t)num_hazards; i++) {
+        int x = (int)(samples[i] % (uint32_t)TileMap->matrix_width);
+        int y = (int)(samples[i] / (uint32_t)TileMap->matrix_width);
+        SetTile(TileMap, x, y, FLOOR_SPIKES);
     }
+
+    RewindArena(TileMap->arena, scratch);
 }
 
+// Plain walls, the autotiler picks the edge pieces like it does for the walls inside
 void InitBorders(MapNode* TileMap) {
 
-    for (int i = 0; i < TileMap->matrix_width; i++) {
-        TileMap->matrix[i][0] = WALL_LEFT;
-        TileMap->matrix[i][TileMap->matrix_width - 1] = WALL_RIGHT;
+    for (int i = 0; i < TileMap->matrix_height; i++) {
+        SetTile(TileMap, 0, i, WALL_MID);
+        SetTile(TileMap, TileMap->matrix_width - 1, i, WALL_MID);
 
-    } for (int j = 0; j < TileMap->matrix_width; j++) {
-        TileMap->matrix[0][j] = WALL_MID;
-        TileMap->matrix[TileMap->matrix_height - 1][j] = WALL_MID;
-    
     }
+
+    uint8_t* top_row = &TileMap->tiles[TileIndex(TileMap, 0, 0)];
+    uint8_t* bottom_row = &TileMap->tiles[TileIndex(TileMap, 0, TileMap->matrix_height - 1)];
+    memset(top_row, WALL_MID, (size_t)TileMap->matrix_width);
+    memset(bottom_row, WALL_MID, (size_t)TileMap->matrix_width);
+}
+
+// Wall piece for a neighbour mask (see autotile.h). Walls inside a run keep the variant they
+// were rolled with, or the plain wall of the borders
+static uint8_t AutotileWall(uint32_t seed, int x, int y, int width, int height, uint8_t tile, uint8_t mask){
+    switch (WallShapes[mask]) {
+        case WALL_SHAPE_LEFT: return WALL_LEFT;
+        case WALL_SHAPE_RIGHT: return WALL_RIGHT;
+        default: break;
+    }
+
+    if (tile != WALL_LEFT && tile != WALL_RIGHT) return tile;
+    if (x == 0 || y == 0 || x == width - 1 || y == height - 1) return WALL_MID;
+    return GetCaveTile(seed, x, y, false);
+}
+
+static void AutotileBand(void* context, int start_row, int end_row){
+    MapNode* TileMap = (MapNode*)context;
+    int width = TileMap->matrix_width;
+    int* columns = (int*)ArenaAlloc(TileMap->arena, sizeof(int) * (size_t)width);
+    uint8_t* masks = (uint8_t*)ArenaAlloc(TileMap->arena, (size_t)width);
+
+    for (int y = start_row; y < end_row; y++) {
+        int count = GetWallMasks(TileMap->blocking, BlockingStride(width), width, TileMap->matrix_height, y, columns, masks);
+        uint8_t* row = &TileMap->tiles[TileIndex(TileMap, 0, y)];
+
+        for (int i = 0; i < count; i++) {
+            uint8_t* tile = &row[columns[i]];
+            if (TileProperties[*tile] & TILE_FLAG_WALL)
+                *tile = AutotileWall(TileMap->seed, columns[i], y, width, TileMap->matrix_height, *tile, masks[i]);
+        }
+    }
+}
+
+// Picks the edge pieces of every wall from the blocking bitset. Only walls next to an open tile
+// are looked at, the others can only be in the middle of a run
+void AutotileWalls(MapNode *TileMap){
+    ArenaMark scratch = GetArenaMark(TileMap->arena); // Masks of the bands
+    ParallelFor(TileMap->matrix_height, GENERATION_BAND_ROWS, AutotileBand, TileMap);
+    RewindArena(TileMap->arena, scratch);
+}
+
+// Autotiles again the walls of [x0, x1] x [y0, y1], for after the tiles in there or next to it
+// changed. Works on streamed maps too
+void AutotileArea(MapNode* TileMap, int x0, int y0, int x1, int y1){
+    static const int offsets[8][2] = { {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1} }; // WallNeighbor order
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= TileMap->matrix_width) x1 = TileMap->matrix_width - 1;
+    if (y1 >= TileMap->matrix_height) y1 = TileMap->matrix_height - 1;
+
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++) {
+            uint8_t tile = GetTile(TileMap, x, y);
+            if (!(TileProperties[tile] & TILE_FLAG_WALL)) continue;
+
+            unsigned mask = 0;
+            for (int k = 0; k < 8; k++) {
+                int next_x = x + offsets[k][0], next_y = y + offsets[k][1];
+                mask |= (unsigned)(!IsInsideMap(TileMap, next_x, next_y) || IsTileBlocking(TileMap, next_x, next_y)) << k;
+            }
+
+            uint8_t autotiled = AutotileWall(TileMap->seed, x, y, TileMap->matrix_width, TileMap->matrix_height, tile, (uint8_t)mask);
+            if (autotiled != tile) SetTile(TileMap, x, y, autotiled);
+        }
+}
+
+bool IsAutotiledTile(uint8_t tile){
+    return tile == WALL_LEFT || tile == WALL_RIGHT;
+}
+
+// Turns the fBm value of a tile into a floor or a wall, the wall variants are rolled from a hash
+// of the tile coordinates. It is stateless, the same (seed, x, y, noise) always gives the same
+// tile, so chunks and row bands can be generated in any order and on any thread
+uint8_t ClassifyCaveTile(uint32_t seed, int x, int y, float noise){
+    return GetCaveTile(seed, x, y, noise < CAVE_FLOOR_THRESHOLD);
+}
+
+uint8_t GetCaveTile(uint32_t seed, int x, int y, bool floor){
+    if (floor) return FLOOR_1; // The variant is only picked when drawing, see GetFloorVariant
+
+
+    // Decorations are scattered, never two side by side
+    uint32_t roll;
+    if (!IsScatterPoint(seed, RNG_STREAM_DECORATION, DECORATION_CELL, x, y, &roll)) return WALL_MID;
+
+    roll %= 10;
+    if (roll < 5) return WALL_HOLE_1;
+    else if (roll < 9) return WALL_HOLE_2;
+    return WALL_BANNER;
 }
 
+// Texture of a plain floor tile. Floors are all stored as FLOOR_1, the decoration is rolled
+// from the tile coordinates so it stays the same for a seed without being kept in the map
+uint8_t GetFloorVariant(uint32_t seed, int x, int y){
+    int variant = (int)(RngHash2D(seed, RNG_STREAM_MAP, x, y) % 30);
+    if(variant > 8 || variant == 0) variant = FLOOR_1;
+    return (uint8_t)variant;
+}
+
+// Smoothed walls of the size x size tiles at (origin_x, origin_y), written to walls (rows stride
+// tiles apart). The automaton runs on those tiles plus iterations tiles around them: the tiles
+// next to the edge of that window are wrong after a step, but the error moves one tile per
+// step, so the tiles asked for come out the same as on a flat map
+static void SmoothChunkWalls(const ChunkManager* manager, int origin_x, int origin_y, int size, uint8_t* walls, int stride){
+    int margin = manager->rules.iterations;
+    int window = size + 2 * margin;
+    float noise[64 * 64];
+    uint64_t planes[2][64];
+    uint64_t outside[64]; // Tiles out of the map, always walls
+
+    fbm2d_block(&manager->noise, origin_x - margin, origin_y - margin, window, window, noise);
+
+    for (int y = 0; y < window; y++) {
+        int map_y = origin_y - margin + y;
+        uint64_t bits = 0, out = 0;
+
+        for (int x = 0; x < window; x++) {
+            int map_x = origin_x - margin + x;
+            uint64_t is_out = map_x < 0 || map_y < 0 || map_x >= manager->map_width || map_y >= manager->map_height;
+
+            out |= is_out << x;
+            bits |= (is_out | (noise[y * window + x] >= CAVE_FLOOR_THRESHOLD)) << x;
+        }
+
+        planes[0][y] = bits;
+        outside[y] = out;
+    }
+
+    int current = 0;
+    for (int step = 0; step < margin; step++) {
+        StepCaveAutomaton(planes[current], planes[!current], 1, window, window, 0, window, manager->rules);
+        for (int y = 0; y < window; y++) planes[!current][y] |= outside[y];
+        current = !current;
+    }
+
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++) {
+            bool floor = !((planes[current][y + margin] >> (x + margin)) & 1);
+            walls[y * stride + x] = GetCaveTile(manager->seed, origin_x + x, origin_y + y, floor);
+        }
+}
+
+// Cave tiles of an area of a streamed map, smoothed, or through the cleanup pass of InitWalls,
+// which needs the tiles one step around the area
+static void CarveCaveArea(const ChunkManager* manager, int x, int y, int size, uint8_t* tiles, int stride){
+    if (manager->rules.iterations > 0) {
+        SmoothChunkWalls(manager, x, y, size, tiles, stride);
+        return;
+    }
+
+    int apron = size + 2;
+    uint8_t walls[64 * 64];
+    float noise[64 * 64];
+
+    fbm2d_block(&manager->noise, x - 1, y - 1, apron, apron, noise);
+
+    for (int j = 0; j < apron; j++)
+        for (int i = 0; i < apron; i++)
+            walls[j * apron + i] = ClassifyCaveTile(manager->seed, x + i - 1, y + j - 1, noise[j * apron + i]);
+
+    // Making sure that the path is clear
+    for (int j = 0; j < size; j++)
+        for (int i = 0; i < size; i++) {
+            const uint8_t* wall = &walls[(j + 1) * apron + (i + 1)];
+            bool surrounded = IsSurroundedByFloor(wall, apron, x + i, y + j, manager->map_width, manager->map_height);
+            tiles[j * stride + i] = surrounded ? FLOOR_1 : *wall;
+        }
+}
+
+static void CarveRoomsArea(const ChunkManager* manager, int x, int y, int size, uint8_t* tiles, int stride){
+    CarveBspRooms(manager->seed, manager->map_width, manager->map_height, x, y, size, size, tiles, stride);
+}
+
+static void CarveWfcArea(const ChunkManager* manager, int x, int y, int size, uint8_t* tiles, int stride){
+    CarveWfcTiles(&wfc_tiles, manager->seed, &manager->noise, manager->map_width, manager->map_height, x, y, size, size, tiles, stride);
+}
+
+static const MapGenerator map_generators[MAP_GENERATOR_COUNT] = {
+    [MAP_GENERATOR_CAVES] = { "CAVES", InitWalls, CarveCaveArea },
+    [MAP_GENERATOR_ROOMS] = { "ROOMS", InitRooms, CarveRoomsArea },
+    [MAP_GENERATOR_WFC]   = { "WFC",   InitWfc,   CarveWfcArea },
+};
+
+static MapGeneratorId map_generator = MAP_GENERATOR_CAVES;
+
+void SetMapGenerator(MapGeneratorId id){
+    if (id >= 0 && id < MAP_GENERATOR_COUNT) map_generator = id;
+}
+
+MapGeneratorId GetMapGenerator(void){
+    return map_generator;
+}
+
+const MapGenerator* GetGeneratorBackend(MapGeneratorId id){
+    return &map_generators[id];
+}
+
+MapGeneratorId FindMapGenerator(const char* name){
+    int id = 0;
+    while (id < MAP_GENERATOR_COUNT && strcasecmp(name, map_generators[id].name) != 0) id++;
+    return (MapGeneratorId)id;
+}
+
+// Generates one chunk of a streamed map, only from the seed and the chunk coordinates.
+// Runs the same stages as GenerateMap, restricted to the tiles of the chunk. The tiles one step
+// around the chunk are generated too, up to the autotiler, so the walls on the edge of the
+// chunk get the same pieces as on a flat map
+void GenerateChunk(ChunkManager* manager, MapChunk* chunk, uint8_t* tiles){
+    enum { WINDOW_SIZE = CHUNK_SIZE + 2 };
+    uint8_t window[WINDOW_SIZE * WINDOW_SIZE]; // Chunk plus one tile around it, before the objects
+    uint64_t window_blocking[WINDOW_SIZE];     // Out of the map tiles are set, like walls
+    int columns[WINDOW_SIZE];
+    uint8_t masks[WINDOW_SIZE];
+
+    int origin_x = chunk->chunk_x << CHUNK_SHIFT;
+    int origin_y = chunk->chunk_y << CHUNK_SHIFT;
+    int width = manager->map_width;
+    int height = manager->map_height;
+    // Chance, out of 32768, that a scatter cell holds an object. About the density of InitObjects,
+    // doubled for the points that land on walls
+    uint32_t objects_chance = (uint32_t)((uint64_t)CHUNK_OBJECT_CELL * CHUNK_OBJECT_CELL * 4 * 32768 / ((uint64_t)width * 10));
+
+    GetGeneratorBackend((MapGeneratorId)manager->generator)->carve_area(manager, origin_x - 1, origin_y - 1, WINDOW_SIZE, window, WINDOW_SIZE);
+
+    for (int y = 0; y < WINDOW_SIZE; y++) {
+        uint64_t blocking = 0;
+
+        for (int x = 0; x < WINDOW_SIZE; x++) {
+            int map_x = origin_x + x - 1;
+            int map_y = origin_y + y - 1;
+            uint8_t tile = window[y * WINDOW_SIZE + x];
+
+            if (map_x < 0 || map_y < 0 || map_x >= width || map_y >= height) {
+                tile = VOID_TILE;
+                blocking |= 1ULL << x;
+            } else {
+                if (abs(map_x - width / 2) <= 1 && abs(map_y - height / 2) <= 1) tile = FLOOR_1;
+                if (map_x == width / 2 && map_y == height / 2 - 1) tile = FLOOR_LADDER; // Same as ClearSpawnPoint
+                if (map_x == 0 || map_y == 0 || map_x == width - 1 || map_y == height - 1) tile = WALL_MID;
+
+                blocking |= (uint64_t)(TileProperties[tile] & TILE_FLAG_BLOCKING) << x;
+            }
+
+            window[y * WINDOW_SIZE + x] = tile;
+        }
+
+        window_blocking[y] = blocking;
+    }
+
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        uint8_t* row = &tiles[y * CHUNK_SIZE];
+        int map_y = origin_y + y;
+        memcpy(row, &window[(y + 1) * WINDOW_SIZE + 1], CHUNK_SIZE);
+
+        int count = GetWallMasks(window_blocking, 1, WINDOW_SIZE, WINDOW_SIZE, y + 1, columns, masks);
+        for (int i = 0; i < count; i++) {
+            int x = columns[i] - 1;
+            if (x < 0 || x >= CHUNK_SIZE || !(TileProperties[row[x]] & TILE_FLAG_WALL)) continue;
+            row[x] = AutotileWall(manager->seed, origin_x + x, map_y, width, height, row[x], masks[i]);
+        }
+
+        uint32_t blocking = 0;
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            int map_x = origin_x + x;
+            bool spawn = abs(map_x - width / 2) <= 2 && abs(map_y - height / 2) <= 2;
+
+            // Only on floors, so never on the ladder, the borders or out of the map
+            uint32_t roll;
+            if (row[x] == FLOOR_1 && !spawn
+                && IsScatterPoint(manager->seed, RNG_STREAM_OBJECTS, CHUNK_OBJECT_CELL, map_x, map_y, &roll)
+                && (roll & 0x7FFF) < objects_chance)
+                row[x] = (roll & 0x8000) ? FLOOR_STAIRS : HOLE;
+
+            blocking |= (uint32_t)(TileProperties[row[x]] & TILE_FLAG_BLOCKING) << x;
+        }
+
+        chunk->blocking[y] = blocking;
+    }
+}
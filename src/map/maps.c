@@ -15,53 +15,145 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "maps.h"
+#include "distance_field.h"
+#include "hazards.h"
+#include "../render/tile_cache.h"
+#include "../entity/enemy.h"
 
-Vector2** SetTilePosition(int matrix_length, int tile_size){
+MapNode* InitMap(int map_lenght, uint32_t seed){
 
-    Vector2** TilesPositions = (Vector2**)malloc((size_t)matrix_length * sizeof(Vector2*));
-    for (int X = 0; X < matrix_length; X++) 
-        TilesPositions[X] = (Vector2*)malloc((size_t)matrix_length * sizeof(Vector2));
+    MapNode* TileMap = (MapNode*)malloc(sizeof(MapNode));
     
-    for (int Y = 0; Y < matrix_length; Y++)
-        for (int X = 0; X < matrix_length; X++)
-            TilesPositions[Y][X] = (Vector2){X * tile_size, Y * tile_size};
-        
-    return TilesPositions;
+    TileMap->node_id = 0;
+    TileMap->seed = seed;
+    TileMap->matrix_width = map_lenght;
+    TileMap->matrix_height = map_lenght;
+    TileMap->tiles = NULL;
+    TileMap->blocking = NULL;
+    TileMap->distance = NULL;
+    TileMap->chunks = NULL;
+    TileMap->hazards = NULL;
+    TileMap->tile_cache = NULL;
+    TileMap->arena = NULL;
+    TileMap->sprites = NULL;
+    TileMap->enemies = NULL;
+    TileMap->num_enemies = 0;
+
+    if (map_lenght > MAP_STREAMING_THRESHOLD) {
+        // Too big to be generated up front, chunks are generated around the camera instead
+        TileMap->chunks = InitChunkManager(seed, map_lenght, map_lenght, CHUNK_MEMORY_BUDGET);
+        TileMap->arena = CreateArena(LEVEL_ARENA_MIN);
+
+    } else {
+        AllocMapPlanes(TileMap);
+    }
+
+    GenerateMap(TileMap);
+
+    return TileMap;
 
 }
 
-MapNode* InitMap(int map_lenght){
+// One allocation for the whole map: the tile ids plane followed by the blocking bitset and the
+// distance field. They are reused by every level of the map, what changes from a level to the
+// next goes to the arena, created here too
+void AllocMapPlanes(MapNode* TileMap){
+    int width = TileMap->matrix_width;
+    int height = TileMap->matrix_height;
 
-    int** mapMatrix = (int**)malloc((size_t)map_lenght * sizeof(int*));
-    Tile** tileMatrix = (Tile**)malloc((size_t)map_lenght * sizeof(Tile*));
+    uint8_t* planes = (uint8_t*)calloc(MapBufferSize(width, height), sizeof(uint8_t));
+    TileMap->tiles = planes;
+    TileMap->blocking = (uint64_t*)(planes + BlockingOffset(width, height));
+    TileMap->distance = planes + MapPlanesSize(width, height);
 
-    for (int i = 0; i < map_lenght; i++){
-        mapMatrix[i] = (int*)malloc((size_t)map_lenght * sizeof(int));
-        tileMatrix[i] = (Tile*)malloc((size_t)map_lenght * sizeof(Tile));
+    if (TileMap->arena == NULL) TileMap->arena = CreateArena(LevelArenaSize(width, height));
+}
+
+void FreeMap(MapNode* TileMap){
+    if (TileMap == NULL) return;
+
+    free(TileMap->tiles); // Also releases the blocking bitset and the distance field
+    FreeChunkManager(TileMap->chunks);
+    FreeHazardList(TileMap->hazards);
+    FreeTileCache(TileMap->tile_cache);
+    DestroyArena(TileMap->arena);
+
+    // Loaded once by PopulateMap and kept by every level, the enemy array holds as many enemies
+    // as the largest level can have
+    if (TileMap->sprites != NULL) FreeTiles(TileMap->sprites);
+    if (TileMap->enemies != NULL) {
+        for (int i = 0; i < GetEnemyCount(TileMap->matrix_width); i++) FreeEnemy(TileMap->enemies[i]);
+        free(TileMap->enemies);
     }
 
-    MapNode* TileMap = (MapNode*)malloc(sizeof(MapNode));
-    
-    TileMap->node_id = 0;
-    TileMap->matrix = mapMatrix;
-    TileMap->matrix_width = map_lenght;
-    TileMap->matrix_height = map_lenght;
-    TileMap->positions = SetTilePosition(map_lenght, __TILE_SIZE);
-    TileMap->tile_info = tileMatrix;
+    free(TileMap);
+}
 
-    for (int Y = 0; Y < map_lenght; Y++){
-        for (int X = 0; X < map_lenght; X++){
-            int pos_x = TileMap->positions[Y][X].x;
-            int pos_y = TileMap->positions[Y][X].y;
-            
-            Rectangle rect = (Rectangle){pos_x, pos_y, __TILE_SIZE, __TILE_SIZE};
-            TileMap->tile_info[Y][X].rect = rect;
+// FNV-1a hash of the tiles and the blocking bitset, the same seed and size must always give the
+// same checksum, whatever the number of threads used to generate the map. Streamed maps return 0
+uint64_t MapChecksum(const MapNode* TileMap){
+    if (TileMap->tiles == NULL) return 0;
 
+    size_t plane_size = MapPlanesSize(TileMap->matrix_width, TileMap->matrix_height);
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < plane_size; i++) {
+        hash ^= TileMap->tiles[i]; // Goes over the whole buffer, the bitset follows the tiles
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// Bits first to last (inclusive, in the same word) of a bitset word
+static inline uint64_t BitRange(int first, int last) {
+    return (~0ULL >> (63 - (last - first))) << first;
+}
+
+// True if any tile overlapped by area (in pixels, right and bottom edges excluded) is
+// blocking. Works on whole bitset words, so a row costs one or two word tests.
+// Leaving the map counts as hitting a wall
+bool IsAreaBlocking(const MapNode* TileMap, Rectangle area){
+    int x0 = (int)floorf(area.x / __TILE_SIZE);
+    int y0 = (int)floorf(area.y / __TILE_SIZE);
+    int x1 = (int)ceilf((area.x + area.width) / __TILE_SIZE) - 1;
+    int y1 = (int)ceilf((area.y + area.height) / __TILE_SIZE) - 1;
+
+    if (x0 < 0 || y0 < 0 || x1 >= TileMap->matrix_width || y1 >= TileMap->matrix_height) return true;
+
+    if (TileMap->chunks != NULL) {
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x = (x | CHUNK_MASK) + 1) {
+                int last = x1 < (x | CHUNK_MASK) ? x1 : (x | CHUNK_MASK);
+                uint32_t row = GetChunk(TileMap->chunks, x, y)->blocking[y & CHUNK_MASK];
+                if (row & BitRange(x & CHUNK_MASK, last & CHUNK_MASK)) return true;
+            }
         }
+        return false;
     }
 
-    GenerateMap(TileMap);
+    // No wall within the area: every tile of it is at most span tiles from the first one, and
+    // a tile k steps away is at most k diagonal steps away
+    int span = (x1 - x0 > y1 - y0) ? x1 - x0 : y1 - y0;
+    if (GetWallDistance(TileMap, x0, y0) > span * DISTANCE_DIAGONAL) return false;
 
-    return TileMap;
+    size_t stride = BlockingStride(TileMap->matrix_width);
+
+    for (int y = y0; y <= y1; y++) {
+        const uint64_t* row = &TileMap->blocking[(size_t)y * stride];
+
+        for (int x = x0; x <= x1; x = (x | 63) + 1) {
+            int last = x1 < (x | 63) ? x1 : (x | 63);
+            if (row[x >> 6] & BitRange(x & 63, last & 63)) return true;
+        }
+    }
+
+    return false;
+}
+
+// Generates the chunks around the camera on streamed maps, does nothing on the others
+void StreamMap(MapNode* TileMap, Camera2D camera){
+    if (TileMap->chunks == NULL) return;
 
+    StreamChunksAround(TileMap->chunks, camera.target);
 }
@@ -19,22 +19,200 @@
 //
 #include "../defs.h"
 #include "../structs.h"
+#include "chunks.h"
+#include "level_cache.h"
+#include "../utils/rng.h"
+#include "../utils/arena.h"
+//
+#define CAVE_FLOOR_THRESHOLD 0.53f // Tiles whose noise is under this value are floors
+//
+// Enemies only depend on the width, and stop growing once the map is streamed
+static inline int GetEnemyCount(int map_width) {
+    return (map_width > MAP_STREAMING_THRESHOLD ? MAP_STREAMING_THRESHOLD : map_width) / 20;
+}
+//
+//====== Tile accessors ============================================================================//
+//
+// The map is stored as a row-major plane of tile ids followed by a blocking bitset, use these
+// helpers instead of indexing them by hand. Everything else about a tile (stairs, holes, ...)
+// comes from its id through TileProperties. Positions and rectangles are not stored.
+//
+extern const uint8_t TileProperties[256]; // Defined in tiles.h
+
+static inline size_t TileIndex(const MapNode* map, int x, int y) {
+    return (size_t)y * (size_t)map->matrix_width + (size_t)x;
+}
+
+// Words of the blocking bitset per row
+static inline size_t BlockingStride(int width) {
+    return ((size_t)width + 63) >> 6;
+}
+
+// Size of the buffer holding the tiles and the blocking bitset, the bitset starts at
+// BlockingOffset (rounded up to a word)
+static inline size_t BlockingOffset(int width, int height) {
+    return ((size_t)width * (size_t)height + 7) & ~(size_t)7;
+}
+
+static inline size_t MapPlanesSize(int width, int height) {
+    return BlockingOffset(width, height) + (size_t)height * BlockingStride(width) * sizeof(uint64_t);
+}
+
+// The distance field follows the planes in the same buffer. It is rebuilt from the blocking
+// bitset, so the cache and the checksums leave it out
+static inline size_t MapBufferSize(int width, int height) {
+    return MapPlanesSize(width, height) + (size_t)width * (size_t)height;
+}
+
+// Bytes the arena of a level starts with, enough for the generation scratch of a flat map
+// (regions and object candidates, 12 bytes per tile at most) so it never has to grow.
+// Streamed maps only keep their spawns in there
+#define LEVEL_ARENA_MIN (64 * 1024)
+
+static inline size_t LevelArenaSize(int width, int height) {
+    return (size_t)width * (size_t)height * 12 + LEVEL_ARENA_MIN;
+}
+
+static inline bool IsInsideMap(const MapNode* map, int x, int y) {
+    return x >= 0 && y >= 0 && x < map->matrix_width && y < map->matrix_height;
+}
+
+static inline uint8_t GetTile(const MapNode* map, int x, int y) {
+    if (map->chunks != NULL) return GetChunkTile(GetChunk(map->chunks, x, y), ChunkTileIndex(x, y));
+    return map->tiles[TileIndex(map, x, y)];
+}
+
+// Keeps the blocking bit in sync, nothing else: call InvalidateArea (map_edit.h) after changing
+// tiles of a finished level. It also logs the change on streamed maps, or it would be lost once
+// the chunk is evicted
+static inline void SetTile(MapNode* map, int x, int y, uint8_t tile) {
+    uint64_t blocking = TileProperties[tile] & TILE_FLAG_BLOCKING;
+
+    if (map->chunks != NULL) {
+        MapChunk* chunk = GetChunk(map->chunks, x, y);
+        uint32_t bit = 1u << (x & CHUNK_MASK);
+
+        SetChunkTile(map->chunks, chunk, ChunkTileIndex(x, y), tile);
+        chunk->blocking[y & CHUNK_MASK] = (chunk->blocking[y & CHUNK_MASK] & ~bit) | ((uint32_t)blocking << (x & CHUNK_MASK));
+    } else {
+        uint64_t* word = &map->blocking[(size_t)y * BlockingStride(map->matrix_width) + (size_t)(x >> 6)];
+
+        map->tiles[TileIndex(map, x, y)] = tile;
+        *word = (*word & ~(1ULL << (x & 63))) | (blocking << (x & 63));
+    }
+}
+
+static inline uint8_t GetTileFlags(const MapNode* map, int x, int y) {
+    return TileProperties[GetTile(map, x, y)];
+}
+
+static inline bool IsTileBlocking(const MapNode* map, int x, int y) {
+    if (map->chunks != NULL) return (GetChunk(map->chunks, x, y)->blocking[y & CHUNK_MASK] >> (x & CHUNK_MASK)) & 1;
+    return (map->blocking[(size_t)y * BlockingStride(map->matrix_width) + (size_t)(x >> 6)] >> (x & 63)) & 1;
+}
+
+static inline bool HasTileFlag(const MapNode* map, int x, int y, uint8_t flag) {
+    return (GetTileFlags(map, x, y) & flag) != 0;
+}
+
+// Returns the tiles of row y starting at column x, and in length how many of them are
+// contiguous in memory (until the end of the row, or of the chunk on streamed maps).
+// Streamed chunks are unpacked into buffer, which must hold CHUNK_SIZE tiles
+static inline const uint8_t* GetTileSpan(const MapNode* map, int x, int y, uint8_t* buffer, int* length) {
+    if (map->chunks != NULL) {
+        *length = CHUNK_SIZE - (x & CHUNK_MASK);
+        DecodeChunkTiles(GetChunk(map->chunks, x, y), ChunkTileIndex(x, y), *length, buffer);
+        return buffer;
+    }
+
+    *length = map->matrix_width - x;
+    return &map->tiles[TileIndex(map, x, y)];
+}
+
+static inline Vector2 GetTilePosition(int x, int y) {
+    return (Vector2){(float)(x * __TILE_SIZE), (float)(y * __TILE_SIZE)};
+}
+
+static inline Rectangle GetTileRect(int x, int y) {
+    return (Rectangle){(float)(x * __TILE_SIZE), (float)(y * __TILE_SIZE), __TILE_SIZE, __TILE_SIZE};
+}
+//
+typedef struct MapRegions MapRegions; // regions.h
+
+// Stages of GenerateLevelData, timed into the GenerationTimings set on the generating thread
+typedef enum {
+    GENERATION_STAGE_CACHE,     // LoadLevelCache and SaveLevelCache
+    GENERATION_STAGE_WALLS,     // Floor / wall layout, from the noise, the rooms or the tile rules
+    GENERATION_STAGE_CLEANUP,   // Cleanup pass, or cave smoothing
+    GENERATION_STAGE_SPAWN,     // ClearSpawnPoint
+    GENERATION_STAGE_BORDERS,   // InitBorders
+    GENERATION_STAGE_TILE_INFO, // GetTileInfo
+    GENERATION_STAGE_REGIONS,   // LabelRegions
+    GENERATION_STAGE_AUTOTILE,  // AutotileWalls
+    GENERATION_STAGE_OBJECTS,   // InitObjects and InitHazards
+    GENERATION_STAGE_DISTANCE,  // BuildDistanceField
+    GENERATION_STAGE_ENEMIES,   // Enemy spawns
+    GENERATION_STAGE_COUNT
+} GenerationStage;
+
+typedef struct {
+    double seconds[GENERATION_STAGE_COUNT]; // Added to, never reset by the generator
+} GenerationTimings;
+
+// Backends laying out the floors and walls of a level. Everything after them (spawn point,
+// borders, regions, autotiling, objects, enemies) is the same for all of them
+typedef enum {
+    MAP_GENERATOR_CAVES,    // Noise caves, smoothed by the cellular automaton (automata.h)
+    MAP_GENERATOR_ROOMS,    // BSP rooms and corridors (bsp.h)
+    MAP_GENERATOR_WFC,      // Wave function collapse over tile rules (wfc.h)
+    MAP_GENERATOR_COUNT
+} MapGeneratorId;
+
+typedef struct {
+    const char* name;       // Shown in the world settings and the tools
+    void (*carve)(MapNode* TileMap); // Tiles of a flat map, times the walls and cleanup stages itself
+    // Tiles of the size x size area at (x, y) of a streamed map, rows stride tiles apart. The
+    // same tiles as carve would give, before the spawn point and the borders
+    void (*carve_area)(const ChunkManager* manager, int x, int y, int size, uint8_t* tiles, int stride);
+} MapGenerator;
 //
 //====== maps.c ====================================================================================//
 //
-Vector2** SetTilePosition(int matrix_length, int tile_size);
-MapNode* InitMap(int MapSize);
+MapNode* InitMap(int MapSize, uint32_t seed);
+void AllocMapPlanes(MapNode* TileMap);
+void FreeMap(MapNode* TileMap);
+bool IsAreaBlocking(const MapNode* TileMap, Rectangle area);
+uint64_t MapChecksum(const MapNode* TileMap);
+void StreamMap(MapNode* TileMap, Camera2D camera);
 //
 //====== map_generator.c ===========================================================================//
 //
 void GenerateMap(MapNode* TileMap);
+void FreeTiles(Sprite* sprites); // Sprites looked up by InitTiles
+bool GenerateLevelData(MapNode* TileMap, EnemySpawn* spawns);
+void PopulateMap(MapNode* TileMap, const EnemySpawn* spawns);
+void SetGenerationTimings(GenerationTimings* timings); // For the calling thread only, NULL stops the timing
+// Backend used by the generator, the same for every thread. Changing it changes every map
+void SetMapGenerator(MapGeneratorId id);
+MapGeneratorId GetMapGenerator(void);
+const MapGenerator* GetGeneratorBackend(MapGeneratorId id);
+MapGeneratorId FindMapGenerator(const char* name); // Any case, MAP_GENERATOR_COUNT if there is none
 //
+uint8_t ClassifyCaveTile(uint32_t seed, int x, int y, float noise);
+uint8_t GetCaveTile(uint32_t seed, int x, int y, bool floor); // FLOOR_1 or the variant of a wall tile
+uint8_t GetFloorVariant(uint32_t seed, int x, int y);          // Sprite drawn for a TILE_FLAG_FLOOR tile
 void InitWalls(MapNode* TileMap);
-bool IsSurroundedByFloor(MapNode *TileMap, int i, int j);
+void InitRooms(MapNode* TileMap);
+void InitWfc(MapNode* TileMap);
+bool IsSurroundedByFloor(const uint8_t* wall, int stride, int x, int y, int width, int height);
 void ClearSpawnPoint(MapNode* TileMap);
-void InitObjects(MapNode* TileMap);
+void InitObjects(MapNode* TileMap, const MapRegions* regions, int region);
+void InitHazards(MapNode* TileMap, const MapRegions* regions, int region);
 void InitBorders(MapNode* TileMap);
 void GetTileInfo(MapNode *TileMap);
+void AutotileWalls(MapNode *TileMap);
+void AutotileArea(MapNode* TileMap, int x0, int y0, int x1, int y1);
+bool IsAutotiledTile(uint8_t tile); // Wall pieces the autotiler puts, rebuilt from the neighbours
 //
 //==================================================================================================//
 //
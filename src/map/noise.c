@@ -15,54 +15,212 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "noise.h"
+#include "../utils/rng.h"
+#include <string.h>
 
-int permutation[PERMUTATION_SIZE] = {0}; // Permutation array for noise generation
+//==============================================================================
+// Vector helpers, the same kernel is built for AVX2, SSE2 or plain floats
+//
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NOISE_LANES 8
+typedef __m256 vfloat;
+#define VSET1(x)      _mm256_set1_ps(x)
+#define VRAMP()       _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)
+#define VADD(a, b)    _mm256_add_ps(a, b)
+#define VSUB(a, b)    _mm256_sub_ps(a, b)
+#define VMUL(a, b)    _mm256_mul_ps(a, b)
+#define VLOAD(p)      _mm256_loadu_ps(p)
+#define VSTORE(p, a)  _mm256_storeu_ps(p, a)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NOISE_LANES 4
+typedef __m128 vfloat;
+#define VSET1(x)      _mm_set1_ps(x)
+#define VRAMP()       _mm_setr_ps(0, 1, 2, 3)
+#define VADD(a, b)    _mm_add_ps(a, b)
+#define VSUB(a, b)    _mm_sub_ps(a, b)
+#define VMUL(a, b)    _mm_mul_ps(a, b)
+#define VLOAD(p)      _mm_loadu_ps(p)
+#define VSTORE(p, a)  _mm_storeu_ps(p, a)
+#else
+#define NOISE_LANES 1
+typedef float vfloat;
+#define VSET1(x)      (x)
+#define VRAMP()       0.0f
+#define VADD(a, b)    ((a) + (b))
+#define VSUB(a, b)    ((a) - (b))
+#define VMUL(a, b)    ((a) * (b))
+#define VLOAD(p)      (*(p))
+#define VSTORE(p, a)  (*(p) = (a))
+#endif
+//
+//==============================================================================
 
-// Function to generate a permutation array (i.e., an array of random numbers)
-void generatePermutation() {
-    srand(time(NULL)); // Seed the random number generator
-    for (int i = 0; i < PERMUTATION_SIZE; i++) {
-        permutation[i] = rand() % PERMUTATION_SIZE;
+// Gradients picked by the low bits of the hash, same set as the original grad():
+// grad(hash, x, y) = gradient_x[hash & 3] * x + gradient_y[hash & 3] * y
+static const float gradient_x[4] = {1.0f, -1.0f, -2.0f, -2.0f};
+static const float gradient_y[4] = {2.0f, 2.0f, 1.0f, -1.0f};
+
+void InitNoise(NoiseContext* ctx, uint32_t seed) {
+    Rng rng;
+    RngSeed(&rng, seed, RNG_STREAM_NOISE);
+
+    for (int i = 0; i < PERMUTATION_SIZE; i++) ctx->permutation[i] = (uint8_t)i;
+
+    // Fisher-Yates, every value appears exactly once
+    for (int i = PERMUTATION_SIZE - 1; i > 0; i--) {
+        int j = (int)RngRange(&rng, (uint32_t)i + 1);
+        uint8_t swap = ctx->permutation[i];
+        ctx->permutation[i] = ctx->permutation[j];
+        ctx->permutation[j] = swap;
     }
+
+    memcpy(ctx->permutation + PERMUTATION_SIZE, ctx->permutation, PERMUTATION_SIZE);
+
+    ctx->frequency = NOISE_FREQUENCY;
+    ctx->octaves = NOISE_OCTAVES;
+    ctx->lacunarity = NOISE_LACUNARITY;
+    ctx->gain = NOISE_GAIN;
 }
 
 // Fade function as defined by Ken Perlin
-double fade(double t) {
-    return t * t * t * (t * (t * 6 - 15) + 10);
+static inline vfloat Fade(vfloat t) {
+    // t * t * t * (t * (t * 6 - 15) + 10)
+    vfloat inner = VADD(VMUL(t, VSUB(VMUL(t, VSET1(6.0f)), VSET1(15.0f))), VSET1(10.0f));
+    return VMUL(VMUL(VMUL(t, t), t), inner);
 }
 
-// Linear interpolation
-double lerp(double t, double a, double b) {
-    return a + t * (b - a);
+// Adds amplitude * noise for count samples of one lattice cell. The corner gradients and the
+// y terms are the same for the whole cell, so only the x terms are evaluated per sample.
+static void AccumulateCell(const float corner[8], vfloat v, float xf_start, float step, int count, float amplitude, float* out) {
+    vfloat gx00 = VSET1(corner[0]), c00 = VSET1(corner[1]);
+    vfloat gx10 = VSET1(corner[2]), c10 = VSET1(corner[3]);
+    vfloat gx01 = VSET1(corner[4]), c01 = VSET1(corner[5]);
+    vfloat gx11 = VSET1(corner[6]), c11 = VSET1(corner[7]);
+    vfloat one = VSET1(1.0f);
+    vfloat amp = VSET1(amplitude);
+    vfloat lane_step = VMUL(VRAMP(), VSET1(step));
+
+    for (int k = 0; k < count; k += NOISE_LANES) {
+        vfloat xf = VADD(VSET1(xf_start + (float)k * step), lane_step);
+        vfloat xf1 = VSUB(xf, one);
+        vfloat u = Fade(xf);
+
+        vfloat n00 = VADD(VMUL(gx00, xf), c00);
+        vfloat n10 = VADD(VMUL(gx10, xf1), c10);
+        vfloat n01 = VADD(VMUL(gx01, xf), c01);
+        vfloat n11 = VADD(VMUL(gx11, xf1), c11);
+
+        vfloat x1 = VADD(n00, VMUL(u, VSUB(n10, n00)));
+        vfloat x2 = VADD(n01, VMUL(u, VSUB(n11, n01)));
+        vfloat value = VMUL(amp, VADD(x1, VMUL(v, VSUB(x2, x1))));
+
+        if (k + NOISE_LANES <= count) {
+            VSTORE(out + k, VADD(VLOAD(out + k), value));
+        } else {
+            float lanes[NOISE_LANES];
+            VSTORE(lanes, value);
+            for (int lane = 0; k + lane < count; lane++) out[k + lane] += lanes[lane];
+        }
+    }
 }
 
-// Gradient function
-double grad(int hash, double x, double y) {
-    int h = hash & 3;
-    double u = h < 2 ? x : y;
-    double v = h < 2 ? y : x;
-    return ((h & 1) ? -u : u) + ((h & 2) ? -2.0 * v : 2.0 * v);
+// Adds amplitude * noise for count samples of a row, at x_start, x_start + step, ... and y
+static void AccumulateRow(const NoiseContext* ctx, float x_start, float y, float step, int count, float amplitude, float* out) {
+    const uint8_t* p = ctx->permutation;
+
+    float y_floor = floorf(y);
+    int yi = (int)y_floor & 255;
+    float yf = y - y_floor;
+    float fade_y = yf * yf * yf * (yf * (yf * 6 - 15) + 10);
+    vfloat v = VSET1(fade_y);
+
+    int k = 0;
+    while (k < count) {
+        float x = x_start + (float)k * step;
+        float x_floor = floorf(x);
+        int xi = (int)x_floor & 255;
+
+        // Samples up to the next lattice line share the same corners
+        int next = (int)ceilf((x_floor + 1.0f - x_start) / step);
+        if (next <= k) next = k + 1;
+        if (next > count) next = count;
+
+        int a = p[xi] + yi;
+        int b = p[xi + 1] + yi;
+        int aa = p[a] & 3, ab = p[a + 1] & 3;
+        int ba = p[b] & 3, bb = p[b + 1] & 3;
+
+        float corner[8] = {
+            gradient_x[aa], gradient_y[aa] * yf,
+            gradient_x[ba], gradient_y[ba] * yf,
+            gradient_x[ab], gradient_y[ab] * (yf - 1.0f),
+            gradient_x[bb], gradient_y[bb] * (yf - 1.0f),
+        };
+
+        AccumulateCell(corner, v, x - x_floor, step, next - k, amplitude, out + k);
+        k = next;
+    }
 }
 
-// 2D Perlin Noise function
-double perlin2d(double x, double y) {
-    int xi = (int)x & 255;
-    int yi = (int)y & 255;
-    double xf = x - (int)x;
-    double yf = y - (int)y;
+// Sums the octaves of the w x h block, returns the total amplitude
+static float AccumulateBlock(const NoiseContext* ctx, int octaves, int x0, int y0, int w, int h, float* out) {
+    float frequency = ctx->frequency;
+    float amplitude = 1.0f;
+    float total = 0.0f;
 
-    double u = fade(xf);
-    double v = fade(yf);
+    memset(out, 0, (size_t)w * (size_t)h * sizeof(float));
 
-    int aa = permutation[(permutation[xi] + yi) % PERMUTATION_SIZE];
-    int ab = permutation[(permutation[xi] + yi + 1) % PERMUTATION_SIZE];
-    int ba = permutation[(permutation[xi + 1] + yi) % PERMUTATION_SIZE];
-    int bb = permutation[(permutation[xi + 1] + yi + 1) % PERMUTATION_SIZE];
+    for (int octave = 0; octave < octaves; octave++) {
+        float offset = (float)octave * 17.31f; // Keeps the octaves from lining up at the origin
 
-    double x1, x2, y1;
-    x1 = lerp(u, grad(aa, xf, yf), grad(ba, xf - 1, yf));
-    x2 = lerp(u, grad(ab, xf, yf - 1), grad(bb, xf - 1, yf - 1));
-    y1 = lerp(v, x1, x2);
+        for (int row = 0; row < h; row++)
+            AccumulateRow(ctx, (float)x0 * frequency + offset, (float)(y0 + row) * frequency + offset,
+                          frequency, w, amplitude, out + (size_t)row * (size_t)w);
+
+        total += amplitude;
+        frequency *= ctx->lacunarity;
+        amplitude *= ctx->gain;
+    }
+
+    return total;
+}
+
+static void NormalizeBlock(float total, int w, int h, float* out) {
+    float scale = 0.5f / total;
+    size_t count = (size_t)w * (size_t)h;
+
+    for (size_t i = 0; i < count; i++) out[i] = out[i] * scale + 0.5f;
+}
+
+void perlin2d_block(const NoiseContext* ctx, int x0, int y0, int w, int h, float* out) {
+    NormalizeBlock(AccumulateBlock(ctx, 1, x0, y0, w, h, out), w, h, out);
+}
+
+void fbm2d_block(const NoiseContext* ctx, int x0, int y0, int w, int h, float* out) {
+    NormalizeBlock(AccumulateBlock(ctx, ctx->octaves, x0, y0, w, h, out), w, h, out);
+}
+
+float perlin2d(const NoiseContext* ctx, float x, float y) {
+    float value = 0.0f;
+    AccumulateRow(ctx, x * ctx->frequency, y * ctx->frequency, ctx->frequency, 1, 1.0f, &value);
+    return value * 0.5f + 0.5f;
+}
+
+float fbm2d(const NoiseContext* ctx, float x, float y) {
+    float frequency = ctx->frequency;
+    float amplitude = 1.0f;
+    float total = 0.0f;
+    float value = 0.0f;
+
+    for (int octave = 0; octave < ctx->octaves; octave++) {
+        float offset = (float)octave * 17.31f;
+        AccumulateRow(ctx, x * frequency + offset, y * frequency + offset, frequency, 1, amplitude, &value);
+        total += amplitude;
+        frequency *= ctx->lacunarity;
+        amplitude *= ctx->gain;
+    }
 
-    return (y1 + 1) / 2;
+    return value * 0.5f / total + 0.5f;
 }
@@ -18,24 +18,37 @@
 #define NOISE_H
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
-#include <time.h>
 
 #define PERMUTATION_SIZE 256
 
-// Function to generate a permutation array (i.e., an array of random numbers)
-void generatePermutation();
-
-// Fade function as defined by Ken Perlin
-double fade(double t);
-
-// Linear interpolation
-double lerp(double t, double a, double b);
-
-// Gradient function
-double grad(int hash, double x, double y);
-
-// 2D Perlin Noise function
-double perlin2d(double x, double y);
+#define NOISE_FREQUENCY (1.0f / 12.0f)  // Noise cells per tile on the first octave
+#define NOISE_OCTAVES 3
+#define NOISE_LACUNARITY 2.0f           // Frequency multiplier between octaves
+#define NOISE_GAIN 0.5f                 // Amplitude multiplier between octaves
+
+// Everything the noise functions need. It is only read after InitNoise, so the same
+// context can be sampled from any number of threads at once.
+typedef struct {
+    uint8_t permutation[PERMUTATION_SIZE * 2]; // 0..255 shuffled from the seed, stored twice so lookups never wrap
+    float frequency;
+    int octaves;
+    float lacunarity;
+    float gain;
+} NoiseContext;
+
+// Shuffles the permutation table from the seed and sets the default fBm parameters
+void InitNoise(NoiseContext* ctx, uint32_t seed);
+
+// Single samples, in [0, 1]. x and y are in tiles, scaled by ctx->frequency
+float perlin2d(const NoiseContext* ctx, float x, float y);
+float fbm2d(const NoiseContext* ctx, float x, float y);
+
+// Samples the w x h tiles starting at (x0, y0) into out (row-major, w * h floats).
+// Evaluates whole rows with SSE2 (or AVX2, when built with -mavx2), much faster than
+// calling the single sample versions in a loop.
+void perlin2d_block(const NoiseContext* ctx, int x0, int y0, int w, int h, float* out);
+void fbm2d_block(const NoiseContext* ctx, int x0, int y0, int w, int h, float* out);
 
 #endif // NOISE_H
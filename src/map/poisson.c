@@ -0,0 +1,133 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "poisson.h"
+
+typedef struct {
+    const MapRegions* regions;
+    int region;
+    PoissonFilter filter;
+    const void* context;
+    float radius_squared;
+    float cell_scale;       // Grid cells per tile
+    int grid_width;
+    int grid_height;
+    uint32_t* cells;        // Sample of every cell plus one, 0 for none
+    uint32_t* samples;
+    uint32_t count;
+} PoissonGrid;
+
+static float RngUnit(Rng* rng){
+    return (float)RngNext(rng) * (1.0f / 4294967296.0f);
+}
+
+// Adds (x, y) to the samples if it is in the region, accepted by the filter and far enough from
+// every other sample. Only the 5 x 5 cells around it can hold one closer than the radius
+static bool TryPlaceSample(PoissonGrid* grid, int x, int y){
+    const MapRegions* regions = grid->regions;
+    if (x < 0 || y < 0 || x >= regions->width || y >= regions->height) return false;
+    if (GetRegion(regions, x, y) != grid->region) return false;
+
+    int cell_x = (int)((float)x * grid->cell_scale);
+    int cell_y = (int)((float)y * grid->cell_scale);
+    if (grid->cells[cell_y * grid->grid_width + cell_x] != 0) return false;
+
+    for (int j = cell_y - 2; j <= cell_y + 2; j++) {
+        if (j < 0 || j >= grid->grid_height) continue;
+
+        for (int i = cell_x - 2; i <= cell_x + 2; i++) {
+            if (i < 0 || i >= grid->grid_width) continue;
+
+            uint32_t cell = grid->cells[j * grid->grid_width + i];
+            if (cell == 0) continue;
+
+            float dx = (float)((int)((cell - 1) % (uint32_t)regions->width) - x);
+            float dy = (float)((int)((cell - 1) / (uint32_t)regions->width) - y);
+            if (dx * dx + dy * dy < grid->radius_squared) return false;
+        }
+    }
+
+    if (!grid->filter(grid->context, x, y)) return false;
+
+    uint32_t tile = (uint32_t)y * (uint32_t)regions->width + (uint32_t)x;
+    grid->cells[cell_y * grid->grid_width + cell_x] = tile + 1;
+    grid->samples[grid->count++] = tile;
+    return true;
+}
+
+uint32_t SamplePoissonDisk(const MapRegions* regions, int region, float radius, PoissonFilter filter,
+                           const void* context, Rng* rng, Arena* arena, uint32_t** samples){
+    float cell_size = radius / sqrtf(2.0f); // Two tiles of a cell are always closer than the radius
+    PoissonGrid grid = {
+        .regions = regions,
+        .region = region,
+        .filter = filter,
+        .context = context,
+        .radius_squared = radius * radius,
+        .cell_scale = 1.0f / cell_size,
+        .grid_width = (int)((float)regions->width / cell_size) + 1,
+        .grid_height = (int)((float)regions->height / cell_size) + 1,
+    };
+
+    // One sample per cell at most
+    size_t cells = (size_t)grid.grid_width * (size_t)grid.grid_height;
+    grid.cells = (uint32_t*)ArenaCalloc(arena, cells, sizeof(uint32_t));
+    grid.samples = (uint32_t*)ArenaAlloc(arena, cells * sizeof(uint32_t));
+    *samples = grid.samples;
+
+    // samples[first_active ..] are still active. When every sample is retired the next patch
+    // starts from a random tile of the region, until POISSON_TRIES of them in a row are taken:
+    // walls can cut a part of the region off from the rings around the samples
+    uint32_t first_active = 0;
+    for (int misses = 0; GetRegionSize(regions, region) > 0 && misses < POISSON_TRIES; ) {
+        uint32_t start = SampleRegion(regions, region, rng);
+        if (!TryPlaceSample(&grid, (int)(start % (uint32_t)regions->width), (int)(start / (uint32_t)regions->width))) {
+            misses++;
+            continue;
+        }
+        misses = 0;
+
+        while (first_active < grid.count) {
+            uint32_t pick = first_active + RngRange(rng, grid.count - first_active);
+            float x = (float)(grid.samples[pick] % (uint32_t)regions->width);
+            float y = (float)(grid.samples[pick] / (uint32_t)regions->width);
+            bool placed = false;
+
+            for (int k = 0; k < POISSON_TRIES && !placed; k++) {
+                float angle = RngUnit(rng) * 6.28318531f;
+                float distance = radius * (1.0f + RngUnit(rng));
+                placed = TryPlaceSample(&grid, (int)floorf(x + distance * cosf(angle) + 0.5f),
+                                        (int)floorf(y + distance * sinf(angle) + 0.5f));
+            }
+
+            if (!placed) {
+                uint32_t retired = grid.samples[pick];
+                grid.samples[pick] = grid.samples[first_active];
+                grid.samples[first_active++] = retired;
+            }
+        }
+    }
+
+    // Fisher-Yates, the patches come out in the order they grew
+    for (uint32_t i = grid.count; i > 1; i--) {
+        uint32_t j = RngRange(rng, i);
+        uint32_t swap = grid.samples[i - 1];
+        grid.samples[i - 1] = grid.samples[j];
+        grid.samples[j] = swap;
+    }
+
+    return grid.count;
+}
@@ -0,0 +1,75 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POISSON_H
+#define POISSON_H
+//
+#include "regions.h"
+//
+// Scattering with a minimum spacing (Poisson-disk sampling), so stairs, holes, spikes, enemies
+// and wall decorations are spread out instead of clumping or landing on each other.
+//
+// Flat maps use Bridson's sampler over the tiles of a region: new samples are tried in the ring
+// between radius and 2 * radius around the active ones, and a background grid of radius / sqrt(2)
+// cells, each holding one sample at most, answers "is anything closer than radius" from 5 x 5
+// cells. The cost follows the area, not the number of samples already placed.
+// Streamed maps only see a chunk at a time, they use scatter cells instead: at most one point per
+// cell, at a position hashed from the cell and kept off its right and bottom edges, so the points
+// of two cells are never side by side.
+//
+#define POISSON_TRIES 30        // Candidates around an active sample before it is retired (Bridson's k)
+#define POISSON_DENSITY 0.7f    // Samples of a filled area, per radius^2 tiles, roughly
+//
+#define OBJECT_SPACING 8.0f     // Minimum distance, in tiles, between stairs and holes
+#define HAZARD_SPACING 5.0f     // Between floor spikes
+#define ENEMY_SPACING 6.0f      // Between enemy spawns
+#define DECORATION_CELL 3       // Holed walls and banners, one per 3x3 tiles at most
+#define CHUNK_OBJECT_CELL 16    // Stairs and holes of streamed maps, one per 16x16 tiles at most
+//
+typedef bool (*PoissonFilter)(const void* context, int x, int y); // Tiles a sample can land on
+//
+//====== poisson.c =================================================================================//
+//
+// Fills the tiles of region accepted by filter with samples (y * width + x) at least radius tiles
+// apart. They come out shuffled, the first n are a uniform pick among them. The samples are
+// allocated in arena, returns their count
+uint32_t SamplePoissonDisk(const MapRegions* regions, int region, float radius, PoissonFilter filter,
+                           const void* context, Rng* rng, Arena* arena, uint32_t** samples);
+//
+//==================================================================================================//
+//
+// Radius giving about twice the wanted samples over area tiles, so a uniform pick among them is
+// spread over the whole region. Never under min_radius
+static inline float GetPoissonRadius(uint32_t area, int wanted, float min_radius) {
+    if (wanted <= 0) return min_radius;
+
+    float radius = sqrtf(POISSON_DENSITY * (float)area / (2.0f * (float)wanted));
+    return radius > min_radius ? radius : min_radius;
+}
+
+// True when (x, y) is the point of its cell x cell block. Points stay in the first cell - 1 rows
+// and columns of their block. roll gets 16 more bits of the hash, to pick what goes there
+static inline bool IsScatterPoint(uint32_t seed, RngStream stream, int cell, int x, int y, uint32_t* roll) {
+    int cell_x = (x >= 0 ? x : x - cell + 1) / cell;
+    int cell_y = (y >= 0 ? y : y - cell + 1) / cell;
+    uint32_t hash = RngHash2D(seed, stream, cell_x, cell_y);
+    uint32_t span = (uint32_t)cell - 1;
+
+    *roll = hash >> 16;
+    return x == cell_x * cell + (int)((hash & 0xFF) % span) && y == cell_y * cell + (int)(((hash >> 8) & 0xFF) % span);
+}
+//
+#endif // POISSON_H
@@ -0,0 +1,108 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "prefetch.h"
+
+static PrefetchSlot slots[PREFETCH_SLOTS];
+
+static void* PrefetchMain(void* arg){
+    PrefetchSlot* slot = (PrefetchSlot*)arg;
+
+    GenerateLevelData(&slot->level, slot->spawns);
+    __atomic_store_n(&slot->state, PREFETCH_READY, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+// Waits for the thread of the slot, if there is one. The result stays in the slot
+static void JoinSlot(PrefetchSlot* slot){
+    if (!slot->joinable) return;
+
+    pthread_join(slot->thread, NULL);
+    slot->joinable = false;
+}
+
+static void ReleaseSlot(PrefetchSlot* slot){
+    JoinSlot(slot);
+    free(slot->level.tiles);
+    DestroyArena(slot->level.arena);
+    free(slot->spawns);
+    memset(slot, 0, sizeof(*slot));
+}
+
+void PrefetchLevel(int index, const MapNode* current, uint32_t seed){
+    if (current->chunks != NULL) return;
+
+    PrefetchSlot* slot = &slots[index];
+    bool same_size = slot->level.matrix_width == current->matrix_width && slot->level.matrix_height == current->matrix_height;
+
+    // Already prefetched (or being prefetched)
+    if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != PREFETCH_EMPTY && same_size && slot->level.seed == seed) return;
+
+    JoinSlot(slot);
+
+    if (!same_size) {
+        ReleaseSlot(slot);
+
+        slot->level.matrix_width = current->matrix_width;
+        slot->level.matrix_height = current->matrix_height;
+        AllocMapPlanes(&slot->level);
+        slot->spawns = malloc(sizeof(EnemySpawn) * (size_t)GetEnemyCount(current->matrix_width));
+    }
+
+    slot->level.seed = seed;
+    slot->state = PREFETCH_RUNNING;
+
+    slot->joinable = pthread_create(&slot->thread, NULL, PrefetchMain, slot) == 0;
+    if (!slot->joinable) slot->state = PREFETCH_EMPTY;
+}
+
+bool TakePrefetchedLevel(MapNode* TileMap, EnemySpawn* spawns){
+    if (TileMap->chunks != NULL) return false;
+
+    for (int i = 0; i < PREFETCH_SLOTS; i++) {
+        PrefetchSlot* slot = &slots[i];
+
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) == PREFETCH_EMPTY || slot->level.seed != TileMap->seed
+            || slot->level.matrix_width != TileMap->matrix_width
+            || slot->level.matrix_height != TileMap->matrix_height) continue;
+
+        JoinSlot(slot); // Returns at once unless the player was faster than the generation
+
+        // The slot keeps the planes of the level that was left, and reuses them next time
+        uint8_t* tiles = TileMap->tiles;
+        uint64_t* blocking = TileMap->blocking;
+        uint8_t* distance = TileMap->distance;
+        TileMap->tiles = slot->level.tiles;
+        TileMap->blocking = slot->level.blocking;
+        TileMap->distance = slot->level.distance;
+        slot->level.tiles = tiles;
+        slot->level.blocking = blocking;
+        slot->level.distance = distance;
+
+        TileMap->num_enemies = slot->level.num_enemies;
+        memcpy(spawns, slot->spawns, sizeof(EnemySpawn) * (size_t)TileMap->num_enemies);
+
+        slot->state = PREFETCH_EMPTY;
+        return true;
+    }
+
+    return false;
+}
+
+void StopPrefetch(void){
+    for (int i = 0; i < PREFETCH_SLOTS; i++) ReleaseSlot(&slots[i]);
+}
@@ -0,0 +1,57 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+//
+#include "maps.h"
+#include <pthread.h>
+//
+// While a level is played, the levels below it (one for the stairs, one for the holes) are
+// generated on a background thread. Taking a stair then swaps the prebuilt planes in instead
+// of generating them. Only the headless part (GenerateLevelData) runs in the background,
+// textures and enemies are still loaded on the main thread by PopulateMap.
+//
+#define PREFETCH_SLOTS 2 // One for each way down
+//
+typedef enum {
+    PREFETCH_EMPTY,
+    PREFETCH_RUNNING,
+    PREFETCH_READY
+} PrefetchState;
+
+typedef struct {
+    MapNode level;          // Headless map, only the size, the seed and the planes are used
+    EnemySpawn* spawns;
+    pthread_t thread;
+    bool joinable;          // The thread was started and not joined yet
+    int state;              // PrefetchState, written by the thread when it finishes
+} PrefetchSlot;
+//
+//====== prefetch.c ================================================================================//
+//
+// Starts generating the level with this seed, and the size of current, in the background.
+// Streamed maps are not prefetched, their levels are generated on demand anyway
+void PrefetchLevel(int slot, const MapNode* current, uint32_t seed);
+// Swaps the level with TileMap->seed into TileMap and fills spawns, waiting for it if it is
+// still being generated. Returns false if that level was never prefetched
+bool TakePrefetchedLevel(MapNode* TileMap, EnemySpawn* spawns);
+// Waits for the running prefetches and releases every slot
+void StopPrefetch(void);
+//
+//==================================================================================================//
+//
+#endif // PREFETCH_H
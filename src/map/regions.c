@@ -0,0 +1,120 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "regions.h"
+
+static int32_t FindRoot(int32_t* parent, int32_t label) {
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]]; // Path halving
+        label = parent[label];
+    }
+    return label;
+}
+
+static int32_t Union(int32_t* parent, int32_t a, int32_t b) {
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+
+    // The smallest label wins, so the result does not depend on the order of the unions
+    if (a < b) { parent[b] = a; return a; }
+    parent[a] = b;
+    return b;
+}
+
+// Flat maps only, streamed maps have no end to label.
+// Two scanline passes: the first gives every tile a provisional label from its left and top
+// neighbours and records which labels touch, the second replaces them with dense region ids.
+// Regions are numbered in the order their first tile appears, top to bottom, left to right
+void LabelRegions(const MapNode* TileMap, MapRegions* regions) {
+    int width = TileMap->matrix_width;
+    int height = TileMap->matrix_height;
+    size_t tile_count = (size_t)width * (size_t)height;
+
+    ArenaMark mark = GetArenaMark(TileMap->arena);
+    int32_t* labels = (int32_t*)ArenaAlloc(TileMap->arena, tile_count * sizeof(int32_t));
+    int32_t* parent = (int32_t*)ArenaAlloc(TileMap->arena, (tile_count + 1) * sizeof(int32_t));
+    int32_t next_label = 0;
+    uint32_t walkable = 0;
+
+    for (int y = 0; y < height; y++) {
+        int32_t* row = &labels[(size_t)y * (size_t)width];
+        const int32_t* top = y > 0 ? row - width : NULL;
+        const uint64_t* blocking = &TileMap->blocking[(size_t)y * BlockingStride(width)];
+        int32_t left = REGION_NONE;
+
+        for (int x = 0; x < width; x++) {
+            if ((blocking[x >> 6] >> (x & 63)) & 1) {
+                row[x] = left = REGION_NONE;
+                continue;
+            }
+
+            int32_t up = top != NULL ? top[x] : REGION_NONE;
+
+            if (left == REGION_NONE && up == REGION_NONE) {
+                parent[next_label] = next_label;
+                left = next_label++;
+            } else if (left == REGION_NONE) {
+                left = up;
+            } else if (up != REGION_NONE && up != left) {
+                left = Union(parent, left, up);
+            }
+
+            row[x] = left;
+            walkable++;
+        }
+    }
+
+    // The smallest label of a set is its root, and labels are handed out in scan order, so going
+    // through the labels in order numbers the regions by their first tile
+    for (int32_t label = 0; label < next_label; label++) parent[label] = FindRoot(parent, label);
+
+    int region_count = 0;
+    for (int32_t label = 0; label < next_label; label++)
+        parent[label] = parent[label] == label ? region_count++ : parent[parent[label]];
+
+    for (size_t i = 0; i < tile_count; i++)
+        if (labels[i] != REGION_NONE) labels[i] = parent[labels[i]];
+
+    // Counting sort of the walkable tiles by region. They go where the parents were, those are
+    // no longer needed
+    uint32_t* region_start = (uint32_t*)ArenaCalloc(TileMap->arena, (size_t)region_count + 1, sizeof(uint32_t));
+    uint32_t* tiles = (uint32_t*)parent;
+
+    for (size_t i = 0; i < tile_count; i++)
+        if (labels[i] != REGION_NONE) region_start[labels[i] + 1]++;
+
+    for (int region = 0; region < region_count; region++) region_start[region + 1] += region_start[region];
+
+    uint32_t* cursor = (uint32_t*)ArenaAlloc(TileMap->arena, ((size_t)region_count + 1) * sizeof(uint32_t));
+    memcpy(cursor, region_start, (size_t)region_count * sizeof(uint32_t));
+
+    for (size_t i = 0; i < tile_count; i++)
+        if (labels[i] != REGION_NONE) tiles[cursor[labels[i]]++] = (uint32_t)i;
+
+    regions->width = width;
+    regions->height = height;
+    regions->labels = labels;
+    regions->tiles = tiles;
+    regions->region_start = region_start;
+    regions->region_count = region_count;
+    regions->arena = TileMap->arena;
+    regions->mark = mark;
+}
+
+void FreeRegions(MapRegions* regions) {
+    RewindArena(regions->arena, regions->mark);
+    memset(regions, 0, sizeof(*regions));
+}
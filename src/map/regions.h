@@ -0,0 +1,59 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef REGIONS_H
+#define REGIONS_H
+//
+#include "maps.h"
+//
+// Connected regions of walkable tiles (4-connected), labeled after the map is generated.
+// The walkable tiles are indexed by region, so a uniformly random reachable tile is one
+// lookup away instead of rolling positions until one lands on a floor.
+//
+#define REGION_NONE (-1) // Label of the blocking tiles
+//
+struct MapRegions {
+    int width;
+    int height;
+    int32_t* labels;        // Region of every tile, row-major, REGION_NONE for blocking tiles
+    uint32_t* tiles;        // Walkable tiles (y * width + x), grouped by region
+    uint32_t* region_start; // Region r owns tiles[region_start[r]] .. tiles[region_start[r + 1] - 1]
+    int region_count;
+    Arena* arena;           // Arena of the map, the arrays are dropped by FreeRegions
+    ArenaMark mark;
+};
+//
+//====== regions.c =================================================================================//
+//
+void LabelRegions(const MapNode* TileMap, MapRegions* regions);
+void FreeRegions(MapRegions* regions); // Also drops what was allocated in the arena after the regions
+//
+//==================================================================================================//
+//
+static inline int GetRegion(const MapRegions* regions, int x, int y) {
+    return regions->labels[(size_t)y * (size_t)regions->width + (size_t)x];
+}
+
+static inline uint32_t GetRegionSize(const MapRegions* regions, int region) {
+    return regions->region_start[region + 1] - regions->region_start[region];
+}
+
+// Uniformly random tile of the region, as y * width + x. The region must not be empty
+static inline uint32_t SampleRegion(const MapRegions* regions, int region, Rng* rng) {
+    return regions->tiles[regions->region_start[region] + RngRange(rng, GetRegionSize(regions, region))];
+}
+//
+#endif // REGIONS_H
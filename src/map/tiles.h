@@ -17,11 +17,11 @@
 #ifndef TILES_H
 #define TILES_H
 
-#include "../defs.h" // Texture2D
+#include "../defs.h" // Sprite
 
 enum TileType {
     VOID_TILE,
-    FLOOR_1,
+    FLOOR_1,        // Every floor is stored as FLOOR_1, FLOOR_2 to FLOOR_8 are only drawn (GetFloorVariant)
     FLOOR_2,
     FLOOR_3,
     FLOOR_4,
@@ -37,6 +37,8 @@ enum TileType {
     WALL_HOLE_1,
     WALL_HOLE_2,
     WALL_BANNER,
+    FLOOR_LADDER,
+    FLOOR_SPIKES,
 
     
     TILE_TYPE_COUNT //Insert before this
@@ -60,9 +62,27 @@ const char* TilePaths[TILE_TYPE_COUNT] = {
     "res/frames/floor_stairs.png",
     "res/frames/wall_hole_1.png",
     "res/frames/wall_hole_2.png",
-    "res/frames/wall_banner.png"
+    "res/frames/wall_banner.png",
+    "res/frames/floor_ladder.png",
+    "res/frames/floor_spikes_anim_f0.png" // Drawn with the frames of hazards.h
 };
 
-Texture2D* InitTiles(void); // Implemented in map_generator.c
+// Flags (TileFlags) of every tile type, indexed by the tile id. Sized for any uint8_t so a
+// lookup never needs a bounds check, the ids after TILE_TYPE_COUNT have no flags
+const uint8_t TileProperties[256] = {
+    [FLOOR_1]       = TILE_FLAG_FLOOR,
+    [WALL_LEFT]     = TILE_FLAG_BLOCKING | TILE_FLAG_WALL,
+    [WALL_MID]      = TILE_FLAG_BLOCKING | TILE_FLAG_WALL,
+    [WALL_RIGHT]    = TILE_FLAG_BLOCKING | TILE_FLAG_WALL,
+    [HOLE]          = TILE_FLAG_BLOCKING | TILE_FLAG_HOLE,
+    [FLOOR_STAIRS]  = TILE_FLAG_BLOCKING | TILE_FLAG_STAIR,
+    [WALL_HOLE_1]   = TILE_FLAG_BLOCKING | TILE_FLAG_WALL | TILE_FLAG_BREAKABLE,
+    [WALL_HOLE_2]   = TILE_FLAG_BLOCKING | TILE_FLAG_WALL | TILE_FLAG_BREAKABLE,
+    [WALL_BANNER]   = TILE_FLAG_BLOCKING | TILE_FLAG_WALL,
+    [FLOOR_LADDER]  = TILE_FLAG_BLOCKING | TILE_FLAG_LADDER,
+    [FLOOR_SPIKES]  = TILE_FLAG_HAZARD,
+};
+
+Sprite* InitTiles(void); // Implemented in map_generator.c
 
 #endif // TILES_H
\ No newline at end of file
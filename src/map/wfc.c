@@ -0,0 +1,343 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "wfc.h"
+#include <string.h>
+
+#define WFC_GRID (WFC_BLOCK_SIZE + 1)   // A square and the seams on both sides of it
+#define WFC_CELLS (WFC_GRID * WFC_GRID)
+#define WFC_NOISE_GRID (WFC_GRID + 2)   // One more tile around, the seams look above and below
+#define WFC_JITTER 1e-3f                // Breaks the ties between cells with the same entropy
+#define WFC_MIN_CHANCE 0.001f           // Lowest floor chance of a cell, and of a wall
+
+typedef uint32_t WfcDomain; // Bit p set while piece p is possible
+
+typedef struct {
+    float key;
+    uint32_t cell;
+} WfcEntry;
+
+// Everything that does not change between squares
+typedef struct {
+    const WfcTileSet* set;
+    uint32_t seed;
+    int width;
+    int height;
+    WfcDomain supports[WFC_DIRECTIONS][1 << WFC_MAX_PIECES]; // Pieces allowed next to any domain
+    float floor_weight[1 << WFC_MAX_PIECES];  // Weights of the floor pieces of any domain
+    float wall_weight[1 << WFC_MAX_PIECES];   // And of the others
+    float floor_log[1 << WFC_MAX_PIECES];     // Sums of weight * log(weight), for the entropy
+    float wall_log[1 << WFC_MAX_PIECES];
+} WfcRules;
+
+typedef struct {
+    WfcDomain domains[WFC_CELLS];
+    float floor_chance[WFC_CELLS];
+    float log_floor[WFC_CELLS];  // log(floor_chance) and log(1 - floor_chance)
+    float log_wall[WFC_CELLS];
+    float entropy[WFC_CELLS];   // Key of the latest heap entry of the cell, older ones are skipped
+    WfcEntry heap[WFC_CELLS * WFC_MAX_PIECES]; // A cell is pushed once, then once per piece it loses
+    int heap_size;
+    uint16_t queue[WFC_CELLS];  // Cells whose neighbours must be checked again
+    bool queued[WFC_CELLS];
+    int queue_head;
+    int queue_size;
+    uint32_t block_seed;
+} WfcBlock;
+
+static const int direction_x[WFC_DIRECTIONS] = {0, 1, 0, -1};
+static const int direction_y[WFC_DIRECTIONS] = {-1, 0, 1, 0};
+
+static void InitRules(WfcRules* rules, const WfcTileSet* set, uint32_t seed, int width, int height){
+    rules->set = set;
+    rules->seed = seed;
+    rules->width = width;
+    rules->height = height;
+
+    for (int d = 0; d < WFC_DIRECTIONS; d++) {
+        WfcDomain allowed[WFC_MAX_PIECES];
+
+        for (int p = 0; p < set->count; p++) {
+            allowed[p] = 0;
+            for (int q = 0; q < set->count; q++)
+                if ((set->pieces[p].allowed[d] >> q & 1) && (set->pieces[q].allowed[(d + 2) % WFC_DIRECTIONS] >> p & 1))
+                    allowed[p] |= 1u << q;
+        }
+
+        // Every domain from the one without its lowest piece
+        rules->supports[d][0] = 0;
+        for (unsigned domain = 1; domain < 1u << set->count; domain++)
+            rules->supports[d][domain] = rules->supports[d][domain & (domain - 1)] | allowed[__builtin_ctz(domain)];
+    }
+
+    rules->floor_weight[0] = rules->wall_weight[0] = rules->floor_log[0] = rules->wall_log[0] = 0.0f;
+    for (unsigned domain = 1; domain < 1u << set->count; domain++) {
+        unsigned rest = domain & (domain - 1);
+        const WfcPiece* piece = &set->pieces[__builtin_ctz(domain)];
+
+        rules->floor_weight[domain] = rules->floor_weight[rest] + (piece->floor ? piece->weight : 0.0f);
+        rules->wall_weight[domain] = rules->wall_weight[rest] + (piece->floor ? 0.0f : piece->weight);
+        rules->floor_log[domain] = rules->floor_log[rest] + (piece->floor ? piece->weight * logf(piece->weight) : 0.0f);
+        rules->wall_log[domain] = rules->wall_log[rest] + (piece->floor ? 0.0f : piece->weight * logf(piece->weight));
+    }
+}
+
+static float PieceWeight(const WfcTileSet* set, int piece, float floor_chance){
+    return set->pieces[piece].weight * (set->pieces[piece].floor ? floor_chance : 1.0f - floor_chance);
+}
+
+// Sum of the weights of the pieces of domain in the cell
+static float DomainWeight(const WfcRules* rules, const WfcBlock* block, uint32_t cell, WfcDomain domain){
+    float chance = block->floor_chance[cell];
+    return chance * rules->floor_weight[domain] + (1.0f - chance) * rules->wall_weight[domain];
+}
+
+// Shannon entropy of the weights left in the domain, plus a small jitter hashed from the cell.
+// The weights are the piece weights times the chance of their kind, so the sum of w * log(w)
+// splits in per domain sums and the logs of the chances
+static float CellKey(const WfcRules* rules, const WfcBlock* block, uint32_t cell){
+    WfcDomain domain = block->domains[cell];
+    float chance = block->floor_chance[cell];
+    float sum = DomainWeight(rules, block, cell, domain);
+    float sum_log = chance * (rules->floor_log[domain] + rules->floor_weight[domain] * block->log_floor[cell])
+                  + (1.0f - chance) * (rules->wall_log[domain] + rules->wall_weight[domain] * block->log_wall[cell]);
+
+    float jitter = (float)(RngHash2D(block->block_seed, RNG_STREAM_WFC, (int)cell, 0) >> 8) * (WFC_JITTER / 16777216.0f);
+    return logf(sum) - sum_log / sum + jitter;
+}
+
+static void PushCell(const WfcRules* rules, WfcBlock* block, uint32_t cell){
+    float key = CellKey(rules, block, cell);
+    int i = block->heap_size++;
+
+    block->entropy[cell] = key;
+    while (i > 0 && block->heap[(i - 1) / 2].key > key) {
+        block->heap[i] = block->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    block->heap[i] = (WfcEntry){key, cell};
+}
+
+static WfcEntry PopCell(WfcBlock* block){
+    WfcEntry top = block->heap[0];
+    WfcEntry last = block->heap[--block->heap_size];
+    int i = 0;
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= block->heap_size) break;
+        if (child + 1 < block->heap_size && block->heap[child + 1].key < block->heap[child].key) child++;
+        if (block->heap[child].key >= last.key) break;
+        block->heap[i] = block->heap[child];
+        i = child;
+    }
+    block->heap[i] = last;
+
+    return top;
+}
+
+static void QueueCell(WfcBlock* block, uint32_t cell){
+    if (block->queued[cell]) return;
+    block->queued[cell] = true;
+    block->queue[(block->queue_head + block->queue_size++) % WFC_CELLS] = (uint16_t)cell;
+}
+
+// Removes the pieces that no longer fit from the neighbours of the queued cells, until nothing
+// changes. Returns false on a contradiction (a cell with no piece left), unless told to ignore
+// them: the cell then keeps the pieces it had
+static bool Propagate(const WfcRules* rules, WfcBlock* block, bool ignore_contradictions){
+    while (block->queue_size > 0) {
+        uint32_t cell = block->queue[block->queue_head];
+        block->queue_head = (block->queue_head + 1) % WFC_CELLS;
+        block->queue_size--;
+        block->queued[cell] = false;
+
+        int x = (int)(cell % WFC_GRID), y = (int)(cell / WFC_GRID);
+        WfcDomain domain = block->domains[cell];
+
+        for (int d = 0; d < WFC_DIRECTIONS; d++) {
+            int next_x = x + direction_x[d], next_y = y + direction_y[d];
+            if (next_x < 0 || next_y < 0 || next_x >= WFC_GRID || next_y >= WFC_GRID) continue;
+
+            uint32_t next = (uint32_t)(next_y * WFC_GRID + next_x);
+            WfcDomain reduced = block->domains[next] & rules->supports[d][domain];
+            if (reduced == block->domains[next]) continue;
+            if (reduced == 0) {
+                if (ignore_contradictions) continue;
+                return false;
+            }
+
+            block->domains[next] = reduced;
+            if (reduced & (reduced - 1)) PushCell(rules, block, next);
+            QueueCell(block, next);
+        }
+    }
+
+    return true;
+}
+
+// Cave noise, with the spawn point open and everything on the border or out of the map closed
+static bool IsSeamFloor(const WfcRules* rules, const float* noise, int map_x, int map_y, int origin_x, int origin_y){
+    if (abs(map_x - rules->width / 2) <= 1 && abs(map_y - rules->height / 2) <= 1) return true;
+    if (map_x <= 0 || map_y <= 0 || map_x >= rules->width - 1 || map_y >= rules->height - 1) return false;
+    return noise[(map_y - origin_y + 1) * WFC_NOISE_GRID + (map_x - origin_x + 1)] < CAVE_FLOOR_THRESHOLD;
+}
+
+// Piece of a tile that is not collapsed. Walls with a floor above and below them are opened,
+// the other walls with a floor below them are fronts, so a column of these follows the rules
+static int GetSeamPiece(const WfcRules* rules, const float* noise, int map_x, int map_y, int origin_x, int origin_y){
+    bool below = IsSeamFloor(rules, noise, map_x, map_y + 1, origin_x, origin_y);
+
+    if (IsSeamFloor(rules, noise, map_x, map_y, origin_x, origin_y)
+        || (below && IsSeamFloor(rules, noise, map_x, map_y - 1, origin_x, origin_y)))
+        return rules->set->floor;
+
+    return below ? rules->set->front : rules->set->wall;
+}
+
+// Seams, the border and the outside of the map, and the spawn point
+static bool IsFixedCell(const WfcRules* rules, int x, int y, int map_x, int map_y){
+    return x == 0 || y == 0 || x == WFC_GRID - 1 || y == WFC_GRID - 1
+        || map_x <= 0 || map_y <= 0 || map_x >= rules->width - 1 || map_y >= rules->height - 1
+        || (abs(map_x - rules->width / 2) <= 1 && abs(map_y - rules->height / 2) <= 1);
+}
+
+// Weight of a piece in the cell, times the share of the weight of every neighbour it leaves.
+// Without it a piece that forces its neighbour (a front, the floor under it) would be picked
+// as often deep in the walls as next to a floor
+static float PieceFit(const WfcRules* rules, const WfcBlock* block, uint32_t cell, int piece){
+    float weight = PieceWeight(rules->set, piece, block->floor_chance[cell]);
+    int x = (int)(cell % WFC_GRID), y = (int)(cell / WFC_GRID);
+
+    for (int d = 0; d < WFC_DIRECTIONS; d++) {
+        int next_x = x + direction_x[d], next_y = y + direction_y[d];
+        if (next_x < 0 || next_y < 0 || next_x >= WFC_GRID || next_y >= WFC_GRID) continue;
+
+        uint32_t next = (uint32_t)(next_y * WFC_GRID + next_x);
+        WfcDomain domain = block->domains[next];
+        weight *= DomainWeight(rules, block, next, domain & rules->supports[d][1u << piece]) / DomainWeight(rules, block, next, domain);
+    }
+
+    return weight;
+}
+
+// Picks a piece of the domain, by fit
+static int PickPiece(const WfcRules* rules, const WfcBlock* block, uint32_t cell, Rng* rng){
+    float fits[WFC_MAX_PIECES];
+    float sum = 0.0f;
+
+    for (WfcDomain domain = block->domains[cell]; domain != 0; domain &= domain - 1) {
+        int piece = __builtin_ctz(domain);
+        fits[piece] = PieceFit(rules, block, cell, piece);
+        sum += fits[piece];
+    }
+
+    float roll = (float)RngNext(rng) * (1.0f / 4294967296.0f) * sum;
+    int piece = __builtin_ctz(block->domains[cell]);
+
+    for (WfcDomain domain = block->domains[cell]; domain != 0; domain &= domain - 1) {
+        piece = __builtin_ctz(domain);
+        roll -= fits[piece];
+        if (roll < 0.0f) break;
+    }
+
+    return piece;
+}
+
+static void SolveBlock(const WfcRules* rules, const NoiseContext* noise_context, int block_x, int block_y, WfcBlock* block){
+    float noise[WFC_NOISE_GRID * WFC_NOISE_GRID];
+    int origin_x = block_x * WFC_BLOCK_SIZE, origin_y = block_y * WFC_BLOCK_SIZE;
+    WfcDomain all = (1u << rules->set->count) - 1;
+
+    fbm2d_block(noise_context, origin_x - 1, origin_y - 1, WFC_NOISE_GRID, WFC_NOISE_GRID, noise);
+    block->block_seed = RngHash2D(rules->seed, RNG_STREAM_WFC, block_x, block_y);
+
+    for (int attempt = 0; attempt < WFC_ATTEMPTS; attempt++) {
+        bool last_attempt = attempt == WFC_ATTEMPTS - 1;
+        Rng rng;
+        RngSeed(&rng, (uint64_t)block->block_seed << 8 | (uint64_t)attempt, RNG_STREAM_WFC);
+
+        block->heap_size = 0;
+        block->queue_head = 0;
+        block->queue_size = 0;
+        memset(block->queued, 0, sizeof(block->queued));
+
+        for (int y = 0; y < WFC_GRID; y++)
+            for (int x = 0; x < WFC_GRID; x++) {
+                uint32_t cell = (uint32_t)(y * WFC_GRID + x);
+                int map_x = origin_x + x, map_y = origin_y + y;
+
+                float chance = 0.5f + (CAVE_FLOOR_THRESHOLD - noise[(y + 1) * WFC_NOISE_GRID + (x + 1)]) * WFC_NOISE_GAIN;
+                block->floor_chance[cell] = chance < WFC_MIN_CHANCE ? WFC_MIN_CHANCE : chance > 1.0f - WFC_MIN_CHANCE ? 1.0f - WFC_MIN_CHANCE : chance;
+                block->log_floor[cell] = logf(block->floor_chance[cell]);
+                block->log_wall[cell] = logf(1.0f - block->floor_chance[cell]);
+
+                if (IsFixedCell(rules, x, y, map_x, map_y)) {
+                    block->domains[cell] = 1u << GetSeamPiece(rules, noise, map_x, map_y, origin_x, origin_y);
+                    QueueCell(block, cell);
+                } else {
+                    block->domains[cell] = all;
+                }
+            }
+
+        if (!Propagate(rules, block, last_attempt)) continue;
+
+        for (uint32_t cell = 0; cell < WFC_CELLS; cell++) {
+            WfcDomain domain = block->domains[cell];
+            if (domain & (domain - 1)) PushCell(rules, block, cell);
+        }
+
+        bool contradiction = false;
+        while (block->heap_size > 0 && !contradiction) {
+            WfcEntry entry = PopCell(block);
+            WfcDomain domain = block->domains[entry.cell];
+            if (!(domain & (domain - 1)) || entry.key != block->entropy[entry.cell]) continue;
+
+            block->domains[entry.cell] = 1u << PickPiece(rules, block, entry.cell, &rng);
+            QueueCell(block, entry.cell);
+            contradiction = !Propagate(rules, block, last_attempt);
+        }
+
+        if (!contradiction) return;
+    }
+}
+
+static int FloorDiv(int value, int divisor){
+    return value >= 0 ? value / divisor : -((divisor - 1 - value) / divisor);
+}
+
+void CarveWfcTiles(const WfcTileSet* set, uint32_t seed, const NoiseContext* noise, int width, int height,
+                   int x0, int y0, int w, int h, uint8_t* tiles, int stride){
+    WfcRules rules;
+    WfcBlock block;
+    InitRules(&rules, set, seed, width, height);
+
+    // A tile on a seam is in two squares, the first one is enough
+    for (int block_y = FloorDiv(y0, WFC_BLOCK_SIZE); block_y <= FloorDiv(y0 + h - 1, WFC_BLOCK_SIZE); block_y++)
+        for (int block_x = FloorDiv(x0, WFC_BLOCK_SIZE); block_x <= FloorDiv(x0 + w - 1, WFC_BLOCK_SIZE); block_x++) {
+            SolveBlock(&rules, noise, block_x, block_y, &block);
+
+            int origin_x = block_x * WFC_BLOCK_SIZE, origin_y = block_y * WFC_BLOCK_SIZE;
+            int start_x = origin_x > x0 ? origin_x : x0, end_x = origin_x + WFC_BLOCK_SIZE < x0 + w ? origin_x + WFC_BLOCK_SIZE : x0 + w;
+            int start_y = origin_y > y0 ? origin_y : y0, end_y = origin_y + WFC_BLOCK_SIZE < y0 + h ? origin_y + WFC_BLOCK_SIZE : y0 + h;
+
+            for (int y = start_y; y < end_y; y++)
+                for (int x = start_x; x < end_x; x++) {
+                    WfcDomain domain = block.domains[(y - origin_y) * WFC_GRID + (x - origin_x)];
+                    tiles[(y - y0) * stride + (x - x0)] = set->pieces[__builtin_ctz(domain)].tile;
+                }
+        }
+}
@@ -0,0 +1,74 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WFC_H
+#define WFC_H
+//
+#include "maps.h"
+#include "noise.h"
+//
+// Wave function collapse over hand written tile rules. A tile set is a list of pieces, each one a
+// tile id and the pieces it may have above, on its right, below and on its left. Every cell
+// starts with all the pieces possible (a bitset, its domain), the cell with the fewest choices
+// left is set to one of them, and the cells next to it lose the pieces that can no longer fit,
+// which can remove pieces from their own neighbours, and so on.
+//
+// The map is cut in WFC_BLOCK_SIZE squares by seam rows and columns that are not collapsed: they
+// come from the cave noise, cleaned up so they follow the rules. Every square is solved on its own
+// from (seed, square) with its seams fixed, so any area of the map can be carved without the rest
+// of it, and the noise also leans the cells of the squares towards the floor or the wall pieces.
+//
+#define WFC_BLOCK_SIZE 32   // Tiles between two seams
+#define WFC_MAX_PIECES 8    // Pieces of a tile set
+#define WFC_ATTEMPTS 4      // Tries of a square, the last one ignores the contradictions
+#define WFC_NOISE_GAIN 32.0f // How hard the noise leans the cells towards floors or walls
+//
+typedef enum {
+    WFC_UP,
+    WFC_RIGHT,
+    WFC_DOWN,
+    WFC_LEFT,
+    WFC_DIRECTIONS
+} WfcDirection;
+
+typedef struct {
+    uint8_t tile;           // Tile id written for the piece
+    bool floor;             // Leaned on where the noise is under CAVE_FLOOR_THRESHOLD, the others above
+    float weight;           // How often the piece is picked, relative to the others (> 0)
+    uint32_t allowed[WFC_DIRECTIONS]; // Bit p set when piece p may be the neighbour on that side
+} WfcPiece;
+
+// A pair of pieces can only be neighbours when both of them allow it. The seams are made of
+// three pieces that must be allowed next to each other the way they are used: floors, walls,
+// and fronts, the walls right above a floor
+typedef struct {
+    const WfcPiece* pieces;
+    int count;
+    int floor;
+    int wall;
+    int front;
+} WfcTileSet;
+//
+//====== wfc.c =====================================================================================//
+//
+// Tiles of the w x h area at (x0, y0) of a width x height map, into tiles (rows stride tiles
+// apart). The area can go past the edges of the map, those tiles are walls
+void CarveWfcTiles(const WfcTileSet* set, uint32_t seed, const NoiseContext* noise, int width, int height,
+                   int x0, int y0, int w, int h, uint8_t* tiles, int stride);
+//
+//==================================================================================================//
+//
+#endif // WFC_H
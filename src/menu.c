@@ -101,6 +101,7 @@ MenuData* menu_screen(void) {
 
 void InitData(void) {
     menuData = (MenuData*)malloc(sizeof(MenuData));
+    InitRandomSeed(NULL);
     menuData->isClient = false;
     menuData->isServer = false;
     menuData->currentState = MENU_MAIN;  // Start at main menu
@@ -108,13 +109,14 @@ void InitData(void) {
     menuData->MapSize = 100;
     menuData->MapSeed = 29072022;
     menuData->MaxSeed = 99999999;
-    menuData->MapMaxSize = 500;
+    menuData->MapMaxSize = 20000;
     menuData->selectedOption = 0;
     menuData->verticalCenter = (SCREEN_HEIGHT - 40 * MAX_OPTIONS) / 2;
     menuData->animFrames = 0;
     menuData->nextFrameDataOffset = 0;
     menuData->map_level = 0;
     menuData->difficulty = 0;
+    menuData->generator = MAP_GENERATOR_CAVES;
     menuData->currentAnimFrame = 0;
     menuData->frameDelay = 10;
     menuData->frameCounter = 0;
@@ -142,7 +144,7 @@ void UpdateRaining(void) {
         menuData->isRaining = false;
     }
 
-    if ((rand() % 10000 < 10) && !menuData->isRaining && !IsSoundPlaying(menuSounds->lightningSound)) {
+    if ((RandomRange(RNG_STREAM_MENU, 10000) < 10) && !menuData->isRaining && !IsSoundPlaying(menuSounds->lightningSound)) {
         PlaySound(menuSounds->lightningSound);
         menuData->isRaining = true;
         menuData->RainingAlpha = 3.0f;
@@ -204,11 +206,12 @@ void DrawMultiplayerMenu(int selectedOption) {
 }
 
 void DrawWorldSettings(int selectedOption) {
-    char option_1[20], option_2[20];
+    char option_1[20], option_2[20], option_3[20];
     sprintf(option_1, "MAP SIZE: %i", menuData->MapSize);
     sprintf(option_2, "MAP SEED: %i", menuData->MapSeed);
-    const char *drawWorldOptions[MAX_OPTIONS] = {option_1, option_2, "BACK", "START GAME"};
-    for (int i = 0; i < MAX_OPTIONS; i++) {
+    sprintf(option_3, "MAP TYPE: %s", GetGeneratorBackend((MapGeneratorId)menuData->generator)->name);
+    const char *drawWorldOptions[WORLD_OPTIONS] = {option_1, option_2, option_3, "BACK", "START GAME"};
+    for (int i = 0; i < WORLD_OPTIONS; i++) {
         Vector2 rectPos = {SCREEN_WIDTH / 2 - 200, menuData->verticalCenter + 60 * i};
         Rectangle optionRect = {rectPos.x, rectPos.y, 400, 40};
         Color color = (i == selectedOption) ? RED : ColorFromNormalized((Vector4){0.44f, 0.44f, 0.44f, 1.0f});
@@ -228,7 +231,8 @@ void DrawOption(const char *text, Rectangle optionRect, Color color) {
 
 void initGame(void) {
     InitRandomSeed((void*)(uintptr_t)menuData->MapSeed);
-    menuData->TileMapGraph = InitMap(menuData->MapSize);
+    SetMapGenerator((MapGeneratorId)menuData->generator);
+    menuData->TileMapGraph = InitMap(menuData->MapSize, (uint32_t)menuData->MapSeed);
     menuData->TileMapGraph->updateEnemies = &UpdateEnemiesMap;
     menuData->TileMapGraph->drawEnemies = &DrawEnemyMap;
     menuData->TileMapGraph->drawMap = &RenderMap;
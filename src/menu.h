@@ -32,6 +32,7 @@
 #define LIGHTNING_SOUND "res/static/lightning.mp3"
 
 #define MAX_OPTIONS 4
+#define WORLD_OPTIONS 5 // Map size, seed, generator, back and start
 
 
 typedef enum {
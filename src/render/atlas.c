@@ -0,0 +1,126 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "atlas.h"
+
+static Texture2D atlas;
+static char sprite_paths[ATLAS_MAX_SPRITES][ATLAS_PATH_LENGTH];
+static Rectangle sprite_sources[ATLAS_MAX_SPRITES];
+static int sprite_count;
+
+static int NextPowerOfTwo(int value){
+    int power = ATLAS_MIN_WIDTH;
+    while (power < value) power *= 2;
+    return power;
+}
+
+// Tallest first, so every shelf wastes little height. The white block goes last
+static void SortByHeight(const Image* images, int* order, int count){
+    for (int i = 0; i < count; i++) order[i] = i;
+
+    for (int i = 1; i < count - 1; i++)
+        for (int j = i; j > 0 && images[order[j]].height > images[order[j - 1]].height; j--) {
+            int swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+}
+
+// Rows (shelves) filled left to right, a new one starts when the next image does not fit
+static Image PackImages(const Image* images, const int* order, int count){
+    int width = 0;
+    for (int i = 0; i < count; i++)
+        if (images[i].width + 2 * ATLAS_PADDING > width) width = images[i].width + 2 * ATLAS_PADDING;
+    width = NextPowerOfTwo(width);
+
+    int x = ATLAS_PADDING, y = ATLAS_PADDING, shelf = 0;
+    for (int i = 0; i < count; i++) {
+        const Image* image = &images[order[i]];
+        if (x + image->width + ATLAS_PADDING > width) {
+            y += shelf + ATLAS_PADDING;
+            x = ATLAS_PADDING;
+            shelf = 0;
+        }
+
+        sprite_sources[order[i]] = (Rectangle){ (float)x, (float)y, (float)image->width, (float)image->height };
+        x += image->width + ATLAS_PADDING;
+        if (image->height > shelf) shelf = image->height;
+    }
+
+    Image packed = GenImageColor(width, NextPowerOfTwo(y + shelf + ATLAS_PADDING), BLANK);
+    for (int i = 0; i < count; i++)
+        ImageDraw(&packed, images[i], (Rectangle){ 0, 0, (float)images[i].width, (float)images[i].height }, sprite_sources[i], WHITE);
+
+    return packed;
+}
+
+void InitAtlas(void){
+    if (atlas.id != 0) return;
+
+    const char* directories[] = ATLAS_DIRECTORIES;
+    Image images[ATLAS_MAX_SPRITES];
+    int order[ATLAS_MAX_SPRITES];
+    sprite_count = 0;
+
+    for (size_t d = 0; d < ARRAY_LEN(directories); d++) {
+        FilePathList files = LoadDirectoryFilesEx(directories[d], ".png", false);
+
+        for (unsigned int i = 0; i < files.count && sprite_count < ATLAS_MAX_SPRITES - 1; i++) {
+            Image image = LoadImage(files.paths[i]);
+            if (image.data == NULL) continue;
+
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            snprintf(sprite_paths[sprite_count], ATLAS_PATH_LENGTH, "%s/%s", directories[d], GetFileName(files.paths[i]));
+            images[sprite_count++] = image;
+        }
+
+        UnloadDirectoryFiles(files);
+    }
+
+    images[sprite_count] = GenImageColor(ATLAS_WHITE_SIZE, ATLAS_WHITE_SIZE, WHITE);
+    sprite_paths[sprite_count][0] = '\0'; // Not a sprite, never found by GetSprite
+    int count = sprite_count + 1;
+
+    SortByHeight(images, order, count);
+    Image packed = PackImages(images, order, count);
+    atlas = LoadTextureFromImage(packed);
+
+    Rectangle white = sprite_sources[sprite_count];
+    SetShapesTexture(atlas, (Rectangle){ white.x + 1, white.y + 1, 1, 1 });
+
+    #ifdef DEBUG
+    printf("Atlas of %d sprites, %dx%d pixels\n", sprite_count, packed.width, packed.height);
+    #endif /* ifndef DEBUG */
+
+    UnloadImage(packed);
+    for (int i = 0; i < count; i++) UnloadImage(images[i]);
+}
+
+void FreeAtlas(void){
+    if (atlas.id == 0) return;
+
+    SetShapesTexture((Texture2D){ 0 }, (Rectangle){ 0 }); // Back to the default white pixel of raylib
+    UnloadTexture(atlas);
+    atlas = (Texture2D){ 0 };
+    sprite_count = 0;
+}
+
+Sprite GetSprite(const char* path){
+    for (int i = 0; i < sprite_count; i++)
+        if (strcmp(sprite_paths[i], path) == 0) return (Sprite){ atlas, sprite_sources[i] };
+
+    return (Sprite){ 0 };
+}
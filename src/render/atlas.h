@@ -0,0 +1,53 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ATLAS_H
+#define ATLAS_H
+//
+#include "../defs.h"
+#include "../structs.h"
+//
+// Every image of ATLAS_DIRECTORIES is packed into one texture when the game starts, tiles,
+// hazards and entities are drawn from their part of it (a Sprite), so raylib keeps them in the
+// same batch instead of starting a new one whenever the texture changes. A white block is packed
+// too and used for the shapes (health bars), which would break the batch as well.
+// Sprites are flipped through their source rectangle, the atlas itself is never changed.
+//
+#define ATLAS_DIRECTORIES { "res/frames", "res/characters" }
+#define ATLAS_MAX_SPRITES 64
+#define ATLAS_PATH_LENGTH 64
+#define ATLAS_MIN_WIDTH 256
+#define ATLAS_PADDING 1         // Transparent pixels between the sprites
+#define ATLAS_WHITE_SIZE 3      // Only the center pixel is sampled by the shapes
+//
+//====== atlas.c ===================================================================================//
+//
+void InitAtlas(void); // After InitWindow
+void FreeAtlas(void); // Before CloseWindow, every Sprite is then empty
+Sprite GetSprite(const char* path); // Same path as for LoadTexture, an empty Sprite when the image is missing
+//
+//==================================================================================================//
+//
+// Part of a sprite sheet, frame in pixels of the sheet
+static inline Rectangle GetSpriteFrame(Sprite sprite, Rectangle frame, bool flipped) {
+    return (Rectangle){ sprite.source.x + frame.x, sprite.source.y + frame.y, flipped ? -frame.width : frame.width, frame.height };
+}
+
+static inline void DrawSprite(Sprite sprite, Vector2 position) {
+    DrawTextureRec(sprite.texture, sprite.source, position, WHITE);
+}
+//
+#endif // ATLAS_H
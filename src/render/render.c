@@ -15,6 +15,22 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "render.h"
+#include "../map/hazards.h"
+#include "tile_cache.h"
+#include "atlas.h"
+
+static RenderStats render_stats;
+
+const RenderStats* GetRenderStats(void){
+    return &render_stats;
+}
+
+// Draw calls that switch texture are the ones that break raylib's batch
+static inline void CountDraw(unsigned int texture_id, unsigned int* last_id){
+    render_stats.draw_calls++;
+    if (texture_id != *last_id) render_stats.texture_binds++;
+    *last_id = texture_id;
+}
 
 void RenderMap(MapNode* nodes, Camera2D camera){
     
@@ -29,18 +45,63 @@ void RenderMap(MapNode* nodes, Camera2D camera){
     start_i = (start_i < 0) ? 0 : start_i;
     start_j = (start_j < 0) ? 0 : start_j;
     end_i = (end_i >= nodes->matrix_height) ? nodes->matrix_height - 1 : end_i;
-    end_j = (end_j >= nodes->matrix_height) ? nodes->matrix_height - 1 : end_j;
+    end_j = (end_j >= nodes->matrix_width) ? nodes->matrix_width - 1 : end_j;
+
+    render_stats = (RenderStats){0};
+    if (start_i > end_i || start_j > end_j) return;
 
+    if (nodes->tile_cache == NULL) nodes->tile_cache = InitTileCache();
+    TileCache* cache = nodes->tile_cache;
+    StartTileCacheFrame(cache, nodes);
 
-    for (int i = start_i; i <= end_i; i++) {
-        for (int j = start_j; j <= end_j; j++) {            
-            
-            int id = nodes->matrix[i][j];
-            DrawTextureEx(nodes->textures[id], nodes->positions[i][j], 0, 1, WHITE);
+    int chunk_i0 = start_i >> TILE_CACHE_SHIFT, chunk_i1 = end_i >> TILE_CACHE_SHIFT;
+    int chunk_j0 = start_j >> TILE_CACHE_SHIFT, chunk_j1 = end_j >> TILE_CACHE_SHIFT;
+    TileCacheSlot* slots[TILE_CACHE_SLOTS];
+    int count = 0;
+    bool stale = false;
 
-            #ifdef DEBUG
-            DrawRectangleLines(nodes->positions[i][j].x, nodes->positions[i][j].y, nodes->textures[id].width, nodes->textures[id].height, RED);
-            #endif /* ifndef DEBUG */
+    for (int ci = chunk_i0; ci <= chunk_i1; ci++)
+        for (int cj = chunk_j0; cj <= chunk_j1; cj++) {
+            slots[count] = GetTileCacheSlot(cache, cj, ci);
+            stale |= !slots[count++]->baked;
         }
+
+    // Texture mode drops the camera, so the chunks are baked between two 2D modes
+    if (stale) {
+        EndMode2D();
+        for (int k = 0; k < count; k++)
+            if (!slots[k]->baked) {
+                BakeTileChunk(nodes, slots[k]);
+                render_stats.baked_chunks++;
+            }
+        BeginMode2D(camera);
+    }
+
+    unsigned int last_id = 0;
+    float chunk_pixels = (float)(TILE_CACHE_CHUNK * __TILE_SIZE);
+
+    // Only the part of every chunk inside the window, render textures are stored upside down
+    for (int k = 0; k < count; k++) {
+        int base_i = slots[k]->chunk_y << TILE_CACHE_SHIFT, base_j = slots[k]->chunk_x << TILE_CACHE_SHIFT;
+        int i0 = start_i > base_i ? start_i : base_i, i1 = end_i < base_i + TILE_CACHE_CHUNK - 1 ? end_i : base_i + TILE_CACHE_CHUNK - 1;
+        int j0 = start_j > base_j ? start_j : base_j, j1 = end_j < base_j + TILE_CACHE_CHUNK - 1 ? end_j : base_j + TILE_CACHE_CHUNK - 1;
+
+        float width = (float)((j1 - j0 + 1) * __TILE_SIZE), height = (float)((i1 - i0 + 1) * __TILE_SIZE);
+        Rectangle source = { (float)((j0 - base_j) * __TILE_SIZE), chunk_pixels - (float)((i0 - base_i) * __TILE_SIZE) - height, width, -height };
+
+        DrawTextureRec(slots[k]->target.texture, source, GetTilePosition(j0, i0), WHITE);
+        CountDraw(slots[k]->target.texture.id, &last_id);
+    }
+
+    // Animated tiles show the frame of their hazard over the baked one
+    HazardList* list = nodes->hazards;
+    if (list == NULL) return;
+
+    for (int k = 0; k < list->count; k++) {
+        const Hazard* hazard = &list->hazards[k];
+        if (hazard->y < start_i || hazard->y > end_i || hazard->x < start_j || hazard->x > end_j) continue;
+
+        DrawSprite(list->frames[hazard->frame], GetTilePosition(hazard->x, hazard->y));
+        CountDraw(list->frames[hazard->frame].texture.id, &last_id);
     }
 }
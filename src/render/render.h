@@ -29,11 +29,20 @@ typedef enum {
     NO_COLLISION = 0x01,
     STAIR = 0x02,
     HOLE = 0x03,
+    LADDER = 0x04,
 
 } CollisionsReturnType;
 
 
-void RenderMap(MapNode* nodes, Camera2D camera);
+// Counted by the last RenderMap, shown in debug builds
+typedef struct {
+    unsigned int draw_calls;
+    unsigned int texture_binds;     // Draws that used another texture than the one before
+    unsigned int baked_chunks;      // Chunks of the tile cache drawn again this frame
+} RenderStats;
+
+void RenderMap(MapNode* nodes, Camera2D camera); // Chunks of the tile cache, then the hazards
+const RenderStats* GetRenderStats(void);
 
 // CAMERA RELATED - FUNCTIONS //
 Camera2D InitPlayerCamera(Player *player);
@@ -0,0 +1,107 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tile_cache.h"
+#include "../map/maps.h"
+#include "atlas.h"
+
+TileCache* InitTileCache(void){
+    TileCache* cache = (TileCache*)calloc(1, sizeof(TileCache));
+    cache->node_id = -1;
+    return cache;
+}
+
+void FreeTileCache(TileCache* cache){
+    if (cache == NULL) return;
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++)
+        if (cache->slots[i].target.id != 0) UnloadRenderTexture(cache->slots[i].target);
+    free(cache);
+}
+
+void StartTileCacheFrame(TileCache* cache, const MapNode* TileMap){
+    cache->frame++;
+    if (cache->node_id == TileMap->node_id && cache->seed == TileMap->seed) return;
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) cache->slots[i].used = false;
+    cache->node_id = TileMap->node_id;
+    cache->seed = TileMap->seed;
+}
+
+TileCacheSlot* GetTileCacheSlot(TileCache* cache, int chunk_x, int chunk_y){
+    TileCacheSlot* oldest = &cache->slots[0];
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        TileCacheSlot* slot = &cache->slots[i];
+
+        if (slot->used && slot->chunk_x == chunk_x && slot->chunk_y == chunk_y) {
+            slot->last_used = cache->frame;
+            return slot;
+        }
+        if (!slot->used || (oldest->used && slot->last_used < oldest->last_used)) oldest = slot;
+    }
+
+    if (oldest->target.id == 0) oldest->target = LoadRenderTexture(TILE_CACHE_CHUNK * __TILE_SIZE, TILE_CACHE_CHUNK * __TILE_SIZE);
+    oldest->chunk_x = chunk_x;
+    oldest->chunk_y = chunk_y;
+    oldest->used = true;
+    oldest->baked = false;
+    oldest->last_used = cache->frame;
+    return oldest;
+}
+
+// The same tiles RenderMap used to draw one by one, hazards show their first frame
+void BakeTileChunk(const MapNode* TileMap, TileCacheSlot* slot){
+    int start_x = slot->chunk_x << TILE_CACHE_SHIFT, start_y = slot->chunk_y << TILE_CACHE_SHIFT;
+    int end_x = start_x + TILE_CACHE_CHUNK < TileMap->matrix_width ? start_x + TILE_CACHE_CHUNK : TileMap->matrix_width;
+    int end_y = start_y + TILE_CACHE_CHUNK < TileMap->matrix_height ? start_y + TILE_CACHE_CHUNK : TileMap->matrix_height;
+
+    BeginTextureMode(slot->target);
+    ClearBackground(BLANK);
+
+    for (int i = start_y; i < end_y; i++) {
+        int span = 0;
+        const uint8_t* row = NULL;
+        uint8_t buffer[CHUNK_SIZE];
+
+        for (int j = start_x; j < end_x; j++, row++, span--) {
+            if (span == 0) row = GetTileSpan(TileMap, j, i, buffer, &span); // Next contiguous run of tiles
+
+            uint8_t id = *row;
+            if (TileProperties[id] & TILE_FLAG_FLOOR) id = GetFloorVariant(TileMap->seed, j, i);
+            Vector2 position = GetTilePosition(j - start_x, i - start_y);
+
+            DrawSprite(TileMap->sprites[id], position);
+
+            #ifdef DEBUG
+            DrawRectangleLines(position.x, position.y, TileMap->sprites[id].source.width, TileMap->sprites[id].source.height, RED);
+            #endif /* ifndef DEBUG */
+        }
+    }
+
+    EndTextureMode();
+    slot->baked = true;
+}
+
+void InvalidateTileCache(TileCache* cache, int x0, int y0, int x1, int y1){
+    if (cache == NULL) return;
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        TileCacheSlot* slot = &cache->slots[i];
+        if (slot->chunk_x >= x0 >> TILE_CACHE_SHIFT && slot->chunk_x <= x1 >> TILE_CACHE_SHIFT
+            && slot->chunk_y >= y0 >> TILE_CACHE_SHIFT && slot->chunk_y <= y1 >> TILE_CACHE_SHIFT) slot->baked = false;
+    }
+}
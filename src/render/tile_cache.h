@@ -0,0 +1,60 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+//
+#include "../defs.h"
+#include "../structs.h"
+//
+// The tile layer barely changes, so it is drawn into render textures of TILE_CACHE_CHUNK x
+// TILE_CACHE_CHUNK tiles once and every frame only draws the few of them under the view, with
+// the animated hazards on top. A chunk is drawn again (baked) when a tile inside it changes
+// (InvalidateArea) or when the level changes. The slots are recycled least recently used first,
+// so a chunk the player walks back to is usually still baked.
+//
+#define TILE_CACHE_SHIFT 5
+#define TILE_CACHE_CHUNK (1 << TILE_CACHE_SHIFT)   // Tiles per side of a chunk, 512 pixels
+#define TILE_CACHE_SLOTS 9                          // The view (RENDER_DISTANCE) covers 4 chunks at most
+//
+typedef struct {
+    RenderTexture2D target; // Loaded the first time the slot is used
+    int chunk_x;            // Chunk coordinates, in chunks (tile_x >> TILE_CACHE_SHIFT)
+    int chunk_y;
+    bool used;              // Holds a chunk of the current level
+    bool baked;             // The texture is up to date with the tiles of the chunk
+    unsigned long last_used; // Frame the chunk was last drawn in
+} TileCacheSlot;
+
+struct TileCache {
+    TileCacheSlot slots[TILE_CACHE_SLOTS];
+    int node_id;            // Level the slots hold chunks of
+    uint32_t seed;
+    unsigned long frame;
+};
+//
+//====== tile_cache.c ==============================================================================//
+//
+TileCache* InitTileCache(void); // Nothing is loaded on the GPU until a chunk is baked
+void FreeTileCache(TileCache* cache);
+void StartTileCacheFrame(TileCache* cache, const MapNode* TileMap); // Drops the chunks of another level
+TileCacheSlot* GetTileCacheSlot(TileCache* cache, int chunk_x, int chunk_y); // Baked or not, kept for this frame
+void BakeTileChunk(const MapNode* TileMap, TileCacheSlot* slot); // Outside BeginMode2D, it resets the camera
+void InvalidateTileCache(TileCache* cache, int x0, int y0, int x1, int y1); // After tiles of [x0, x1] x [y0, y1] changed
+//
+//==================================================================================================//
+//
+#endif // TILE_CACHE_H
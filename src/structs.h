@@ -30,8 +30,10 @@
 typedef struct Entity Entity;
 typedef struct Enemy Enemy;
 typedef struct Player Player;
-typedef struct Tile Tile;
 typedef struct MapNode MapNode;
+typedef struct ChunkManager ChunkManager;
+typedef struct HazardList HazardList;
+typedef struct TileCache TileCache;
 typedef struct GameVariables GameVariables;
 
 #define MAX_INPUT_CHARS 12
@@ -48,9 +50,15 @@ typedef enum {
 //
 //==============================================================================
 
+// Image packed in the sprite atlas (see render/atlas.h)
+typedef struct {
+    Texture2D texture;      // The atlas, id 0 when the image is missing
+    Rectangle source;       // Pixels of the image in the atlas
+} Sprite;
+
 struct Entity{
-    Texture2D texture;      // Texture to represent the player
-    Rectangle frameRec;     // Sprite frame rectangle (Used to animate the player)   
+    Sprite sprite;          // Sprite sheet to represent the player
+    Rectangle frameRec;     // Sprite frame rectangle, in pixels of the sheet (Used to animate the player)   
     Vector2 spawn_point;   
     Vector2 position;       
     Vector2 last_position;  
@@ -65,6 +73,7 @@ struct Entity{
     bool isAttacking;
     bool isMoving;
     bool isPlayer;  
+    bool flipped;           // Drawn mirrored, the sheets face one side only
 };
 
 struct Enemy {
@@ -85,22 +94,33 @@ struct Player {
 
 };
 
-struct Tile{
-    Rectangle rect;         // Rectangle of the tile (Used for collision detection)
-    bool blocking;          // Used to check if the tile can block entities
-    bool isBreakable;       // Used to check if the tile can be broken
-    bool isStair;           // Used to check if the tile is a stair
-    bool isHole;            // Used to check if the tile is a hole
-};
+// Properties of a tile type, looked up in TileProperties (tiles.h). Only the blocking bit is
+// stored per tile, in MapNode.blocking. The tile rectangle and position are not stored
+// either, they are computed from (x, y) * __TILE_SIZE (see maps.h)
+typedef enum {
+    TILE_FLAG_BLOCKING  = 1 << 0,   // Used to check if the tile can block entities
+    TILE_FLAG_BREAKABLE = 1 << 1,   // Used to check if the tile can be broken
+    TILE_FLAG_STAIR     = 1 << 2,   // Used to check if the tile is a stair
+    TILE_FLAG_HOLE      = 1 << 3,   // Used to check if the tile is a hole
+    TILE_FLAG_LADDER    = 1 << 4,   // Used to check if the tile leads to the level above
+    TILE_FLAG_WALL      = 1 << 5,   // Wall pieces, the autotiler only changes these
+    TILE_FLAG_HAZARD    = 1 << 6,   // Animated hazards, listed in MapNode.hazards
+    TILE_FLAG_FLOOR     = 1 << 7,   // Plain floor, drawn with a variant derived from its position
+} TileFlags;
 
 struct MapNode{
-    Tile** tile_info;       // Tile info is used to store the tile information (blocking, breakable, etc.)
-    Vector2** positions;    // Positions of the each tile in the map, calculated with: (x * tile_size, y * tile_size)
-    Texture2D* textures;    // Textures of the tiles
-    int node_id;            // ID of the node, will be used in the future to identify new maps when the player uses a stair  
+    uint8_t* tiles;         // Map layout, row-major: tiles[y * matrix_width + x] (0:void, 1: floor, (9-11): wall, etc.), floors 2-8 are only drawn
+    uint64_t* blocking;     // One bit per tile, set for blocking tiles. Rows are padded to whole words (see maps.h). Lives in the same buffer as tiles
+    uint8_t* distance;      // Distance from every tile to the closest wall (see distance_field.h). Also in the buffer of tiles, NULL on streamed maps
+    ChunkManager* chunks;   // Used instead of tiles/blocking on streamed maps (see chunks.h), NULL otherwise
+    HazardList* hazards;    // Sparse list of the hazard tiles of the level (see hazards.h)
+    TileCache* tile_cache;  // Baked chunks of the tile layer (see render/tile_cache.h), NULL until drawn
+    struct Arena* arena;    // Everything that lives as long as the level, reset on level change (see utils/arena.h)
+    uint32_t seed;          // Seed of the current level
+    Sprite* sprites;        // Sprites of the tiles, indexed by the tile id
+    int node_id;            // ID of the level in the level graph (see level_graph.h)
     int matrix_width;       // Width of the matrix
     int matrix_height;      // The height and width are the same because the map is a square
-    int** matrix;           // Matrix is used to store the map layout (0:void, (1-8): floor, (9-11): wall, etc.)
     int num_enemies;        // Number of enemies in the map
     Enemy** enemies;         // Array of enemies in the map
 
@@ -140,6 +160,7 @@ typedef struct {
     float RainingAlpha;
     uint16_t map_level;
     uint8_t difficulty;
+    uint8_t generator;       // MapGeneratorId picked in the world settings
     uint8_t currentAnimFrame;
     uint8_t frameDelay;
     uint8_t frameCounter;
@@ -0,0 +1,340 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Headless benchmark of the map generator: no window, no textures and no level cache.
+// Generates flat maps (even above MAP_STREAMING_THRESHOLD) for every size and seed and prints
+// the time of every stage, the memory used and the checksum as JSON, so runs of two versions
+// can be compared. Built with ./run.sh linux bench
+//
+// Usage: MapBench [--sizes 50,100,500,2000,5000] [--seeds 3] [--threads 0] [--cave-iterations 3] [--breaks 0]
+//                 [--generator caves|rooms|wfc]
+//        MapBench --check
+//
+// With --breaks, that many cracked walls are broken on every generated map, picked from the seed,
+// and the average cost of every invalidation stage (see map_edit.h) is printed with the run.
+//
+// With --check, the maps of golden_maps are generated again with 1, 2, 4 and 8 threads and their
+// checksums compared with the table, MapBench exits with 1 on a mismatch. A commit that changes the generated maps
+// on purpose (the ones that bump LEVEL_CACHE_VERSION) updates the table with the printed values.
+//
+// Allocations are counted by wrapping malloc and friends (-Wl,--wrap, see run.sh), so only the
+// allocations made by the game code are counted, not the ones made inside libc.
+
+#include "../defs.h"
+#include "../map/maps.h"
+#include "../map/automata.h"
+#include "../map/map_edit.h"
+#include "../utils/threads.h"
+#include <malloc.h>
+#include <sys/resource.h>
+
+#define MAX_BENCH_SIZES 16
+#define CHECK_WORKER_COUNTS { 1, 2, 4, 8 } // The bands of a stage must give the same tiles whatever thread runs them
+
+static const char* stage_names[GENERATION_STAGE_COUNT] = {
+    [GENERATION_STAGE_CACHE] = "cache",
+    [GENERATION_STAGE_WALLS] = "walls",
+    [GENERATION_STAGE_CLEANUP] = "cleanup",
+    [GENERATION_STAGE_SPAWN] = "spawn",
+    [GENERATION_STAGE_BORDERS] = "borders",
+    [GENERATION_STAGE_TILE_INFO] = "tile_info",
+    [GENERATION_STAGE_REGIONS] = "regions",
+    [GENERATION_STAGE_AUTOTILE] = "autotile",
+    [GENERATION_STAGE_OBJECTS] = "objects",
+    [GENERATION_STAGE_DISTANCE] = "distance",
+    [GENERATION_STAGE_ENEMIES] = "enemies",
+};
+
+static const char* invalidation_stage_names[INVALIDATION_STAGE_COUNT] = {
+    [INVALIDATION_STAGE_TILES] = "tiles",
+    [INVALIDATION_STAGE_AUTOTILE] = "autotile",
+    [INVALIDATION_STAGE_DISTANCE] = "distance",
+    [INVALIDATION_STAGE_HAZARDS] = "hazards",
+    [INVALIDATION_STAGE_CHUNKS] = "chunks",
+};
+
+// Checksums of GenerateLevelData with the default cave rules, a given seed must always give the same map
+typedef struct {
+    MapGeneratorId generator;
+    int size;
+    uint32_t seed;
+    uint64_t checksum;
+} GoldenMap;
+
+static const GoldenMap golden_maps[] = {
+    { MAP_GENERATOR_CAVES, 50, 1, 0x02c6eb1fcccab4b1ULL },
+    { MAP_GENERATOR_CAVES, 200, 1, 0x5ced2f2a2acd137aULL },
+    { MAP_GENERATOR_CAVES, 200, 2, 0x190acde079476993ULL },
+    { MAP_GENERATOR_CAVES, 100, 23, 0xb088c835e49a8e09ULL }, // The corridor from the spawn point used to dig through the ladder
+    { MAP_GENERATOR_CAVES, 600, 3, 0xfe4be351edfd62bcULL },
+    { MAP_GENERATOR_ROOMS, 50, 1, 0xb0468d1382bfe0a9ULL },
+    { MAP_GENERATOR_ROOMS, 200, 1, 0x4a003ad430496347ULL },
+    { MAP_GENERATOR_ROOMS, 200, 2, 0x42fd1e3786b118eaULL },
+    { MAP_GENERATOR_ROOMS, 50, 79, 0x86b0ac614535d506ULL },  // Same
+    { MAP_GENERATOR_ROOMS, 600, 3, 0xc5cc17c11d974596ULL },
+    { MAP_GENERATOR_WFC, 50, 1, 0x8b0700d2aea44bf8ULL },
+    { MAP_GENERATOR_WFC, 200, 1, 0xeac8abff8fb732c3ULL },
+    { MAP_GENERATOR_WFC, 200, 2, 0x31a41ff861d6e0d1ULL },
+    { MAP_GENERATOR_WFC, 100, 44, 0xe18003c8ccc96632ULL },   // Same
+    { MAP_GENERATOR_WFC, 600, 3, 0x4226f5eb4a77fbd7ULL },
+};
+
+//==============================================================================
+// Allocation counters
+//
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+static int64_t allocated_bytes = 0; // Everything allocated since the counters were reset
+static int64_t live_bytes = 0;
+static int64_t peak_live_bytes = 0;
+
+static void CountAllocation(void* pointer){
+    if (pointer == NULL) return;
+
+    int64_t size = (int64_t)malloc_usable_size(pointer);
+    __atomic_add_fetch(&allocated_bytes, size, __ATOMIC_RELAXED);
+    int64_t live = __atomic_add_fetch(&live_bytes, size, __ATOMIC_RELAXED);
+
+    int64_t peak = __atomic_load_n(&peak_live_bytes, __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&peak_live_bytes, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void CountFree(void* pointer){
+    if (pointer == NULL) return;
+    __atomic_sub_fetch(&live_bytes, (int64_t)malloc_usable_size(pointer), __ATOMIC_RELAXED);
+}
+
+void* __wrap_malloc(size_t size){
+    void* pointer = __real_malloc(size);
+    CountAllocation(pointer);
+    return pointer;
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+    void* pointer = __real_calloc(count, size);
+    CountAllocation(pointer);
+    return pointer;
+}
+
+void* __wrap_realloc(void* pointer, size_t size){
+    CountFree(pointer);
+    void* moved = __real_realloc(pointer, size);
+    CountAllocation(moved != NULL ? moved : pointer); // On failure the old block is still there
+    return moved;
+}
+
+void __wrap_free(void* pointer){
+    CountFree(pointer);
+    __real_free(pointer);
+}
+
+static void ResetAllocationCounters(void){
+    __atomic_store_n(&allocated_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&peak_live_bytes, __atomic_load_n(&live_bytes, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+//
+//==============================================================================
+
+static long PeakRssKilobytes(void){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // Kilobytes on Linux
+}
+
+static double BenchClock(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static int ParseSizes(const char* list, int* sizes){
+    int count = 0;
+
+    while (*list != '\0' && count < MAX_BENCH_SIZES) {
+        char* end;
+        long size = strtol(list, &end, 10);
+        if (end == list) break;
+
+        if (size > 0) sizes[count++] = (int)size;
+        list = (*end == ',') ? end + 1 : end;
+    }
+
+    return count;
+}
+
+// Breaks up to count cracked walls, picked at random from the whole map, and prints the average
+// cost of a break per invalidation stage
+static void BenchBreaks(MapNode* map, int count){
+    InvalidationTimings timings = {0};
+    Rng rng;
+    RngSeed(&rng, map->seed, RNG_STREAM_MENU);
+
+    // Cracked walls are a few in a thousand, bounded so maps without them do not spin
+    for (long tries = 0; (int)timings.invalidations < count && tries < (long)count * 100000; tries++) {
+        int x = (int)RngRange(&rng, (uint32_t)map->matrix_width);
+        int y = (int)RngRange(&rng, (uint32_t)map->matrix_height);
+        if (!HasTileFlag(map, x, y, TILE_FLAG_BREAKABLE)) continue;
+
+        SetInvalidationTimings(&timings);
+        BreakTile(map, x, y);
+        SetInvalidationTimings(NULL);
+    }
+
+    double breaks = timings.invalidations > 0 ? (double)timings.invalidations : 1.0;
+    printf(", \"breaks\": %lu, \"break_us\": {", timings.invalidations);
+    for (int stage = 0; stage < INVALIDATION_STAGE_COUNT; stage++)
+        printf("%s\"%s\": %.3f", stage == 0 ? "" : ", ", invalidation_stage_names[stage], timings.seconds[stage] * 1e6 / breaks);
+    printf("}, \"break_tiles\": {");
+    for (int stage = 0; stage < INVALIDATION_STAGE_COUNT; stage++)
+        printf("%s\"%s\": %.1f", stage == 0 ? "" : ", ", invalidation_stage_names[stage], (double)timings.tiles[stage] / breaks);
+    printf("}");
+}
+
+// Allocated by hand, InitMap would stream the big sizes and load textures
+static MapNode* AllocBenchMap(int size, uint32_t seed){
+    MapNode* map = (MapNode*)calloc(1, sizeof(MapNode));
+    map->matrix_width = size;
+    map->matrix_height = size;
+    map->seed = seed;
+    AllocMapPlanes(map);
+    return map;
+}
+
+// Generates every golden map again with every worker count, returns the mismatches
+static int CheckGoldenMaps(void){
+    const int worker_counts[] = CHECK_WORKER_COUNTS;
+    int mismatches = 0;
+
+    for (size_t w = 0; w < ARRAY_LEN(worker_counts); w++) {
+        SetWorkerCount(worker_counts[w]);
+
+        for (size_t i = 0; i < ARRAY_LEN(golden_maps); i++) {
+            const GoldenMap* golden = &golden_maps[i];
+            EnemySpawn* spawns = (EnemySpawn*)malloc(sizeof(EnemySpawn) * (size_t)GetEnemyCount(golden->size));
+
+            SetMapGenerator(golden->generator);
+            MapNode* map = AllocBenchMap(golden->size, golden->seed);
+            GenerateLevelData(map, spawns);
+            uint64_t checksum = MapChecksum(map);
+
+            bool match = checksum == golden->checksum;
+            mismatches += !match;
+            printf("%-6s %5d %3u  %d threads  %016llx  %s\n", GetGeneratorBackend(golden->generator)->name, golden->size,
+                   golden->seed, worker_counts[w], (unsigned long long)checksum, match ? "ok" : "MISMATCH");
+
+            free(spawns);
+            FreeMap(map);
+        }
+    }
+
+    printf("%zu maps checked, %d mismatches\n", ARRAY_LEN(golden_maps) * ARRAY_LEN(worker_counts), mismatches);
+    return mismatches;
+}
+
+// One generation, printed as a JSON object
+static void BenchLevel(int size, uint32_t seed, int breaks, bool first){
+    GenerationTimings timings = {0};
+    EnemySpawn* spawns = (EnemySpawn*)malloc(sizeof(EnemySpawn) * (size_t)GetEnemyCount(size));
+
+    ResetAllocationCounters();
+    double start = BenchClock();
+
+    MapNode* map = AllocBenchMap(size, seed);
+
+    SetGenerationTimings(&timings);
+    GenerateLevelData(map, spawns);
+    SetGenerationTimings(NULL);
+
+    double total = BenchClock() - start;
+
+    printf("%s\n    {\"size\": %d, \"seed\": %u, \"total_ms\": %.3f, \"stages_ms\": {", first ? "" : ",", size, seed, total * 1000.0);
+    for (int stage = 0; stage < GENERATION_STAGE_COUNT; stage++)
+        printf("%s\"%s\": %.3f", stage == 0 ? "" : ", ", stage_names[stage], timings.seconds[stage] * 1000.0);
+    printf("}, \"allocated_bytes\": %lld, \"peak_live_bytes\": %lld, \"peak_rss_kb\": %ld, \"enemies\": %d, \"checksum\": \"%016llx\"",
+           (long long)allocated_bytes, (long long)peak_live_bytes, PeakRssKilobytes(), map->num_enemies,
+           (unsigned long long)MapChecksum(map));
+    printf(", \"arena\": {\"allocations\": %lu, \"high_water_bytes\": %zu, \"reserved_bytes\": %zu, \"system_allocations\": %lu}",
+           map->arena->peak_allocations, map->arena->high_water, map->arena->reserved_bytes, map->arena->system_allocations);
+    if (breaks > 0) BenchBreaks(map, breaks);
+    printf("}");
+    fflush(stdout);
+
+    free(spawns);
+    FreeMap(map);
+}
+
+int main(int argc, char* argv[]){
+    int sizes[MAX_BENCH_SIZES] = {50, 100, 500, 2000, 5000};
+    int size_count = 5;
+    int seeds = 3;
+    int breaks = 0;
+    CaveRules rules = GetCaveRules();
+    MapGeneratorId generator = GetMapGenerator();
+    bool check = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+            continue;
+        }
+
+        if (i + 1 == argc) {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return 1;
+        }
+
+        const char* value = argv[++i];
+        if (strcmp(argv[i - 1], "--sizes") == 0) size_count = ParseSizes(value, sizes);
+        else if (strcmp(argv[i - 1], "--seeds") == 0) seeds = atoi(value);
+        else if (strcmp(argv[i - 1], "--threads") == 0) SetWorkerCount(atoi(value));
+        else if (strcmp(argv[i - 1], "--cave-iterations") == 0) rules.iterations = atoi(value);
+        else if (strcmp(argv[i - 1], "--breaks") == 0) breaks = atoi(value);
+        else if (strcmp(argv[i - 1], "--generator") == 0) generator = FindMapGenerator(value);
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+            return 1;
+        }
+    }
+
+    if (generator == MAP_GENERATOR_COUNT) {
+        fprintf(stderr, "Unknown generator\n");
+        return 1;
+    }
+
+    SetLevelCacheEnabled(false);
+    if (check) return CheckGoldenMaps() > 0;
+
+    SetCaveRules(rules);
+    SetMapGenerator(generator);
+
+    printf("{\n  \"threads\": %d,\n  \"generator\": \"%s\",\n  \"cave_iterations\": %d,\n  \"runs\": [", GetWorkerCount(),
+           GetGeneratorBackend(generator)->name, GetCaveRules().iterations);
+
+    bool first = true;
+    for (int i = 0; i < size_count; i++)
+        for (int seed = 1; seed <= seeds; seed++) {
+            BenchLevel(sizes[i], (uint32_t)seed, breaks, first);
+            first = false;
+        }
+
+    printf("\n  ],\n  \"peak_rss_kb\": %ld\n}\n", PeakRssKilobytes());
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Headless seed explorer: generates the first level of every world seed in a range, on every
+// core, and writes one line per seed with what a level designer looks at when picking MapSeed.
+// Nothing is loaded on the GPU and the level cache is not used. Built with ./run.sh linux seeds
+//
+// Usage: SeedExplorer [--first 0] [--count 1000] [--size 100] [--threads 0] [--format csv|json]
+//                     [--generator caves|rooms|wfc]
+//
+// Columns: seed, floor_ratio (walkable tiles / all tiles), regions (4-connected walkable
+// regions), spawn_share (part of the walkable tiles reachable from the spawn point), stairs and
+// holes (placed / reachable from the spawn point), ladder (1 when the ladder back to the level
+// above is right above the spawn point, 0 when the level lost it), enemies and generation time
+// in microseconds.
+
+#include "../defs.h"
+#include "../map/maps.h"
+#include "../map/regions.h"
+#include "../utils/threads.h"
+
+#define SEED_BAND_SIZE 64 // Seeds given to a worker at a time
+
+typedef struct {
+    uint32_t seed;
+    float floor_ratio;
+    float spawn_share;
+    int regions;
+    int stairs;
+    int reachable_stairs;
+    int holes;
+    int reachable_holes;
+    int ladder;
+    int enemies;
+    float generation_us;
+} SeedReport;
+
+typedef struct {
+    uint32_t first_seed;
+    int size;
+    SeedReport* reports;
+} ExploreJob;
+
+static double ExplorerClock(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+// A stair or a hole is reachable when the player can stand next to it
+static bool IsNextToRegion(const MapRegions* regions, int x, int y, int region){
+    return (x > 0 && GetRegion(regions, x - 1, y) == region) || (x + 1 < regions->width && GetRegion(regions, x + 1, y) == region)
+        || (y > 0 && GetRegion(regions, x, y - 1) == region) || (y + 1 < regions->height && GetRegion(regions, x, y + 1) == region);
+}
+
+static void ReportLevel(const MapNode* map, SeedReport* report){
+    MapRegions regions;
+    LabelRegions(map, &regions);
+
+    int spawn_region = GetRegion(&regions, map->matrix_width / 2, map->matrix_height / 2);
+    uint32_t walkable = regions.region_start[regions.region_count];
+
+    report->regions = regions.region_count;
+    report->floor_ratio = (float)walkable / (float)(map->matrix_width * map->matrix_height);
+    report->spawn_share = (spawn_region == REGION_NONE || walkable == 0) ? 0.0f : (float)GetRegionSize(&regions, spawn_region) / (float)walkable;
+    report->enemies = map->num_enemies;
+    report->ladder = HasTileFlag(map, map->matrix_width / 2, map->matrix_height / 2 - 1, TILE_FLAG_LADDER); // See ClearSpawnPoint
+
+    for (int y = 0; y < map->matrix_height; y++)
+        for (int x = 0; x < map->matrix_width; x++) {
+            uint8_t flags = GetTileFlags(map, x, y);
+            if (!(flags & (TILE_FLAG_STAIR | TILE_FLAG_HOLE))) continue;
+
+            bool reachable = spawn_region != REGION_NONE && IsNextToRegion(&regions, x, y, spawn_region);
+            if (flags & TILE_FLAG_STAIR) { report->stairs++; report->reachable_stairs += reachable; }
+            if (flags & TILE_FLAG_HOLE) { report->holes++; report->reachable_holes += reachable; }
+        }
+
+    FreeRegions(&regions);
+}
+
+// Every band reuses one headless map. ParallelFor is already taken by this job, so the
+// generator runs its own stages on the calling thread
+static void ExploreBand(void* context, int start, int end){
+    ExploreJob* job = (ExploreJob*)context;
+    MapNode map = { .matrix_width = job->size, .matrix_height = job->size };
+    EnemySpawn* spawns = (EnemySpawn*)malloc(sizeof(EnemySpawn) * (size_t)GetEnemyCount(job->size));
+    AllocMapPlanes(&map);
+
+    for (int i = start; i < end; i++) {
+        SeedReport* report = &job->reports[i];
+        *report = (SeedReport){ .seed = job->first_seed + (uint32_t)i };
+
+        map.seed = report->seed;
+        double generation_start = ExplorerClock();
+        GenerateLevelData(&map, spawns);
+        report->generation_us = (float)((ExplorerClock() - generation_start) * 1e6);
+
+        ReportLevel(&map, report);
+    }
+
+    free(map.tiles);
+    DestroyArena(map.arena);
+    free(spawns);
+}
+
+static void PrintReports(const SeedReport* reports, int count, bool json){
+    if (json) printf("[\n");
+    else printf("seed,floor_ratio,regions,spawn_share,stairs,reachable_stairs,holes,reachable_holes,ladder,enemies,generation_us\n");
+
+    for (int i = 0; i < count; i++) {
+        const SeedReport* r = &reports[i];
+
+        if (json)
+            printf("  {\"seed\": %u, \"floor_ratio\": %.4f, \"regions\": %d, \"spawn_share\": %.4f, \"stairs\": %d, \"reachable_stairs\": %d, "
+                   "\"holes\": %d, \"reachable_holes\": %d, \"ladder\": %d, \"enemies\": %d, \"generation_us\": %.1f}%s\n",
+                   r->seed, r->floor_ratio, r->regions, r->spawn_share, r->stairs, r->reachable_stairs,
+                   r->holes, r->reachable_holes, r->ladder, r->enemies, r->generation_us, i + 1 < count ? "," : "");
+        else
+            printf("%u,%.4f,%d,%.4f,%d,%d,%d,%d,%d,%d,%.1f\n", r->seed, r->floor_ratio, r->regions, r->spawn_share,
+                   r->stairs, r->reachable_stairs, r->holes, r->reachable_holes, r->ladder, r->enemies, r->generation_us);
+    }
+
+    if (json) printf("]\n");
+}
+
+int main(int argc, char* argv[]){
+    ExploreJob job = { .first_seed = 0, .size = 100 };
+    int count = 1000;
+    bool json = false;
+    MapGeneratorId generator = GetMapGenerator();
+
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 == argc) {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return 1;
+        }
+
+        if (strcmp(argv[i], "--first") == 0) job.first_seed = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--count") == 0) count = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--size") == 0) job.size = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) SetWorkerCount(atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--format") == 0) json = strcmp(argv[i + 1], "json") == 0;
+        else if (strcmp(argv[i], "--generator") == 0) generator = FindMapGenerator(argv[i + 1]);
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (count <= 0 || job.size < 3) {
+        fprintf(stderr, "Nothing to explore\n");
+        return 1;
+    }
+
+    if (generator == MAP_GENERATOR_COUNT) {
+        fprintf(stderr, "Unknown generator\n");
+        return 1;
+    }
+
+    SetMapGenerator(generator);
+    SetLevelCacheEnabled(false);
+    job.reports = (SeedReport*)malloc(sizeof(SeedReport) * (size_t)count);
+
+    double start = ExplorerClock();
+    ParallelFor(count, SEED_BAND_SIZE, ExploreBand, &job);
+    double elapsed = ExplorerClock() - start;
+
+    PrintReports(job.reports, count, json);
+    fprintf(stderr, "%d seeds of %dx%d in %.2f s on %d threads (%.0f seeds/s)\n", count, job.size, job.size,
+            elapsed, GetWorkerCount(), (double)count / elapsed);
+
+    free(job.reports);
+    return 0;
+}
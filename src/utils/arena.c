@@ -0,0 +1,127 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+static ArenaBlock* NewBlock(Arena* arena, size_t size){
+    ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + ARENA_ALIGNMENT + size);
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+
+    arena->reserved_bytes += size;
+    arena->system_allocations++;
+    return block;
+}
+
+// Start of the usable bytes of a block, aligned
+static uint8_t* BlockData(ArenaBlock* block){
+    uintptr_t data = (uintptr_t)(block + 1);
+    return (uint8_t*)((data + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1));
+}
+
+Arena* CreateArena(size_t size){
+    Arena* arena = (Arena*)calloc(1, sizeof(Arena));
+    pthread_mutex_init(&arena->lock, NULL);
+
+    arena->first = arena->current = NewBlock(arena, size);
+    return arena;
+}
+
+void DestroyArena(Arena* arena){
+    if (arena == NULL) return;
+
+    for (ArenaBlock* block = arena->first; block != NULL; ) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+}
+
+void* ArenaAlloc(Arena* arena, size_t size){
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    pthread_mutex_lock(&arena->lock);
+
+    // Free blocks too small for this allocation are skipped until the next reset
+    ArenaBlock* block = arena->current;
+    while (block->size - block->used < size) {
+        if (block->next == NULL) {
+            size_t grown = arena->reserved_bytes > size ? arena->reserved_bytes : size; // Doubles the arena
+            block->next = NewBlock(arena, grown);
+        }
+
+        block = block->next;
+        block->used = 0;
+    }
+
+    void* pointer = BlockData(block) + block->used;
+    block->used += size;
+    arena->current = block;
+
+    arena->used_bytes += size;
+    arena->allocations++;
+    if (arena->used_bytes > arena->high_water) arena->high_water = arena->used_bytes;
+    if (arena->allocations > arena->peak_allocations) arena->peak_allocations = arena->allocations;
+
+    pthread_mutex_unlock(&arena->lock);
+    return pointer;
+}
+
+void* ArenaCalloc(Arena* arena, size_t count, size_t size){
+    void* pointer = ArenaAlloc(arena, count * size);
+    memset(pointer, 0, count * size);
+    return pointer;
+}
+
+// Constant time, unless the arena had to grow since the last reset: its blocks are merged into
+// one as big as all of them, so the next levels fit in a single block
+void ResetArena(Arena* arena){
+    if (arena->first->next != NULL) {
+        size_t size = arena->reserved_bytes;
+
+        for (ArenaBlock* block = arena->first; block != NULL; ) {
+            ArenaBlock* next = block->next;
+            free(block);
+            block = next;
+        }
+
+        arena->reserved_bytes = 0;
+        arena->first = NewBlock(arena, size);
+    }
+
+    arena->current = arena->first;
+    arena->first->used = 0;
+    arena->used_bytes = 0;
+    arena->allocations = 0;
+    arena->resets++;
+}
+
+ArenaMark GetArenaMark(Arena* arena){
+    return (ArenaMark){ arena->current, arena->current->used, arena->used_bytes };
+}
+
+void RewindArena(Arena* arena, ArenaMark mark){
+    arena->current = mark.block;
+    arena->current->used = mark.used;
+    arena->used_bytes = mark.used_bytes;
+}
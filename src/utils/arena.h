@@ -0,0 +1,69 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define ARENA_ALIGNMENT 16
+
+// Bump allocator for what lives as long as a level. Allocations are never freed one by one:
+// ResetArena drops all of them at once and RewindArena drops the ones made since a mark (the
+// scratch buffers of a generation stage). The blocks are kept, so once the largest level of a
+// session was seen nothing more is asked to the system. ArenaAlloc may be called from the
+// threads of a ParallelFor, marks and resets only from the thread that owns the arena.
+typedef struct Arena Arena;
+typedef struct ArenaBlock ArenaBlock;
+
+struct ArenaBlock {
+    ArenaBlock* next;
+    size_t size;            // Usable bytes, after the header
+    size_t used;
+};
+
+struct Arena {
+    ArenaBlock* first;
+    ArenaBlock* current;    // Allocations come from here, the blocks after it are free
+    size_t reserved_bytes;  // Sum of the block sizes
+    size_t used_bytes;      // Since the last reset, padding included
+    size_t high_water;      // Most bytes ever used at once
+    unsigned long allocations;       // Since the last reset, rewinds do not lower it
+    unsigned long peak_allocations;  // Most allocations between two resets
+    unsigned long system_allocations; // Blocks asked to the system
+    unsigned long resets;
+    pthread_mutex_t lock;
+};
+
+typedef struct {
+    ArenaBlock* block;
+    size_t used;
+    size_t used_bytes;
+} ArenaMark;
+
+Arena* CreateArena(size_t size); // One block of size bytes to start with
+void DestroyArena(Arena* arena);
+void* ArenaAlloc(Arena* arena, size_t size); // Not cleared
+void* ArenaCalloc(Arena* arena, size_t count, size_t size);
+void ResetArena(Arena* arena);
+ArenaMark GetArenaMark(Arena* arena);
+void RewindArena(Arena* arena, ArenaMark mark);
+
+#endif // ARENA_H
@@ -0,0 +1,62 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "rng.h"
+
+static Rng streams[RNG_STREAM_COUNT];
+
+void RngSeed(Rng* rng, uint64_t seed, uint64_t stream){
+    rng->state = 0;
+    rng->increment = (SplitMix64(stream) << 1) | 1; // Must be odd
+    RngNext(rng);
+    rng->state += SplitMix64(seed);
+    RngNext(rng);
+}
+
+uint32_t RngNext(Rng* rng){
+    uint64_t old_state = rng->state;
+    rng->state = old_state * 6364136223846793005ULL + rng->increment;
+
+    uint32_t xorshifted = (uint32_t)(((old_state >> 18) ^ old_state) >> 27);
+    uint32_t rotation = (uint32_t)(old_state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+}
+
+// Lemire's multiply and reject method, no modulo bias
+uint32_t RngRange(Rng* rng, uint32_t bound){
+    if (bound == 0) return 0;
+
+    uint64_t product = (uint64_t)RngNext(rng) * bound;
+    uint32_t low = (uint32_t)product;
+
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = (uint64_t)RngNext(rng) * bound;
+            low = (uint32_t)product;
+        }
+    }
+
+    return (uint32_t)(product >> 32);
+}
+
+void SeedRandomStreams(uint64_t seed){
+    for (int i = 0; i < RNG_STREAM_COUNT; i++) RngSeed(&streams[i], seed, (uint64_t)i);
+}
+
+uint32_t RandomRange(RngStream stream, uint32_t bound){
+    return RngRange(&streams[stream], bound);
+}
@@ -0,0 +1,70 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Every subsystem draws from its own stream, so adding a roll in one of them does not
+// change what the others get. Map generation never uses the global streams: it seeds its
+// own generators from the level seed (or hashes the tile coordinates), so a seed always
+// gives the same map.
+typedef enum {
+    RNG_STREAM_LEVELS,      // Seeds of the levels, derived from the world seed
+    RNG_STREAM_MAP,         // Walls and floors
+    RNG_STREAM_DECORATION,  // Wall variants (holes, banners)
+    RNG_STREAM_OBJECTS,     // Stairs and holes
+    RNG_STREAM_ENEMIES,     // Enemy spawns
+    RNG_STREAM_NOISE,       // Perlin permutation table
+    RNG_STREAM_AUDIO,       // Sound variations
+    RNG_STREAM_MENU,        // Menu effects and seed rolls
+    RNG_STREAM_HAZARDS,     // Floor spikes and their phase
+    RNG_STREAM_ROOMS,       // BSP splits, rooms and corridors
+    RNG_STREAM_WFC,         // Wave function collapse picks
+    RNG_STREAM_COUNT
+} RngStream;
+
+// PCG32 generator (https://www.pcg-random.org), the stream selects the increment,
+// so two generators with the same seed and different streams are independent
+typedef struct {
+    uint64_t state;
+    uint64_t increment;
+} Rng;
+
+void RngSeed(Rng* rng, uint64_t seed, uint64_t stream);
+uint32_t RngNext(Rng* rng);
+uint32_t RngRange(Rng* rng, uint32_t bound);  // Uniform in [0, bound)
+
+// Global streams, used by everything that does not need to be reproducible
+void SeedRandomStreams(uint64_t seed);
+uint32_t RandomRange(RngStream stream, uint32_t bound);
+
+static inline uint64_t SplitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Stateless mode: the same (seed, stream, x, y) always gives the same value, whatever order
+// the tiles are visited in and whatever thread visits them
+static inline uint32_t RngHash2D(uint64_t seed, RngStream stream, int x, int y) {
+    uint64_t coords = (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+    return (uint32_t)(SplitMix64(SplitMix64(seed ^ (uint64_t)stream << 56) ^ coords) >> 32);
+}
+
+#endif // RNG_H
@@ -0,0 +1,126 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "threads.h"
+#include <stdint.h>
+#include <unistd.h>
+
+typedef struct {
+    pthread_mutex_t submit;     // Only one job at a time
+    pthread_mutex_t lock;       // Protects everything below
+    pthread_cond_t wake;        // Signals the workers that a new job was posted
+    pthread_cond_t done;        // Signals the caller that a worker finished the job
+    pthread_t threads[MAX_WORKERS];
+    int thread_count;           // Workers started so far, they live until the game exits
+    unsigned long generation;   // Incremented for every job
+    int running;                // Workers that did not finish the current job yet
+    int job_workers;            // Workers that take part in the current job
+
+    ParallelTask task;
+    void* context;
+    int count;
+    int band_size;
+    int next_band;              // Next band to be taken, updated atomically
+} WorkerPool;
+
+static WorkerPool pool = {
+    .submit = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static int worker_count = 0;
+
+void SetWorkerCount(int count){
+    worker_count = count;
+}
+
+int GetWorkerCount(void){
+    if (worker_count > 0) return worker_count > MAX_WORKERS ? MAX_WORKERS : worker_count;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) return 1;
+    return cores > MAX_WORKERS ? MAX_WORKERS : (int)cores;
+}
+
+static void RunBands(void){
+    for (;;) {
+        int band = __atomic_fetch_add(&pool.next_band, 1, __ATOMIC_RELAXED);
+        int start = band * pool.band_size;
+        if (start >= pool.count) return;
+
+        int end = start + pool.band_size;
+        pool.task(pool.context, start, end > pool.count ? pool.count : end);
+    }
+}
+
+static void* WorkerMain(void* arg){
+    int id = (int)(intptr_t)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.generation == seen) pthread_cond_wait(&pool.wake, &pool.lock);
+        seen = pool.generation;
+
+        if (id < pool.job_workers) {
+            pthread_mutex_unlock(&pool.lock);
+            RunBands();
+            pthread_mutex_lock(&pool.lock);
+        }
+
+        if (--pool.running == 0) pthread_cond_signal(&pool.done);
+    }
+
+    return NULL;
+}
+
+void ParallelFor(int count, int band_size, ParallelTask task, void* context){
+    int workers = GetWorkerCount() - 1; // The calling thread works too
+
+    if (workers <= 0 || count <= band_size || pthread_mutex_trylock(&pool.submit) != 0) {
+        task(context, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+
+    while (pool.thread_count < workers) {
+        if (pthread_create(&pool.threads[pool.thread_count], NULL, WorkerMain, (void*)(intptr_t)pool.thread_count) != 0) break;
+        pthread_detach(pool.threads[pool.thread_count]);
+        pool.thread_count++;
+    }
+
+    pool.task = task;
+    pool.context = context;
+    pool.count = count;
+    pool.band_size = band_size;
+    pool.next_band = 0;
+    pool.job_workers = workers;
+    pool.running = pool.thread_count;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    RunBands();
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.running > 0) pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&pool.submit);
+}
@@ -0,0 +1,39 @@
+// This file is part of DungeonDelveC.
+// Copyright (C) 2024 - 2025 Guilherme Oliveira Santos
+
+// DungeonDelveC is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#define MAX_WORKERS 64
+
+// Processes the items [start, end) of a parallel job
+typedef void (*ParallelTask)(void* context, int start, int end);
+
+// Splits [0, count) in bands of band_size items and runs them on the worker pool, the
+// calling thread also takes bands. Returns when every band is done. Bands may run in any
+// order, so tasks must not depend on each other. If the pool is already busy (another
+// thread is inside ParallelFor) the whole job runs on the calling thread.
+void ParallelFor(int count, int band_size, ParallelTask task, void* context);
+
+// Number of threads used by ParallelFor, including the calling thread.
+// 0 (default) uses one per core.
+void SetWorkerCount(int count);
+int GetWorkerCount(void);
+
+#endif // THREADS_H
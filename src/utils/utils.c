@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "utils.h"
+#include "../render/render.h"
 
 typedef struct {
     float value;
@@ -65,6 +66,11 @@ void ShowControls(void)
     DrawText("Attack - SPACE", 40, 60, 10, WHITE);
     DrawText("Interact - E ", 40, 80, 10, WHITE);
     DrawText(fps, 40, 100, 10, WHITE);    
+
+    #ifdef DEBUG
+    const RenderStats* stats = GetRenderStats();
+    DrawText(TextFormat("Map draws: %u | Binds: %u | Baked: %u", stats->draw_calls, stats->texture_binds, stats->baked_chunks), 40, 120, 10, WHITE);
+    #endif /* ifndef DEBUG */
     
 }
 
@@ -100,12 +106,12 @@ void InitRandomSeed(void* value){
         time_t time_time = time(NULL);
         pid_t pid = getpid();
 
-        srand(mix((unsigned long)clock_time, (unsigned long)time_time, (unsigned long)pid));
+        SeedRandomStreams(mix((unsigned long)clock_time, (unsigned long)time_time, (unsigned long)pid));
 
         return;
     }
 
-    srand((unsigned long)value);
+    SeedRandomStreams((uint64_t)(uintptr_t)value);
 }
 
 // Robert Jenkins' 96 bit Mix Function
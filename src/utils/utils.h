@@ -21,6 +21,7 @@
 #include "../structs.h"
 #include "../entity/player.h"
 #include "../menu.h"
+#include "rng.h"
 
 #include <time.h>
 #include <sys/types.h>